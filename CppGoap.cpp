@@ -1,24 +1,45 @@
 #include <iostream>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <sstream>
 
 #include "type.h"
 #include "predicate.h"
 #include "action.h"
 #include "domain.h"
 #include "goal.h"
+#include "goaltemplate.h"
 #include "planner.h"
+#include "batchplanner.h"
+#include "parallelplanner.h"
+#include "planningservice.h"
+#include "planningtask.h"
+#include "staticdomain.h"
+#include "generator.h"
+#include "callbackregistry.h"
+#include "domainloader.h"
+#include "domainimage.h"
+#include "allocationcounter.h"
 
 namespace ai
 {
     namespace goap
     {
+        // Interned once domain is made
+        namespace symbols
+        {
+            Symbol tree, pile, wood, stone, quarry;
+        }
+
         namespace predicates
         {
             bool exists(Agent *, const std::vector<Value> &values, const PredicateBind &bind)
             {
-                const std::size_t index{ bind.slots[0] };
+                const Symbol symbol{ values[bind.slot(0)].asSymbol() };
 
-                if (values[index].value == "tree" || values[index].value == "pile")
+                if (symbol == symbols::tree || symbol == symbols::pile)
                     return true;
 
                 return false;
@@ -40,10 +61,32 @@ namespace ai
             }
         }
 
+        // Goal p holds through q, or through r once q doesn't hold
+        namespace relay
+        {
+            bool q{ true }, r{ false };
+
+            bool p(Agent *, const std::vector<Value> &, const PredicateBind &)
+            {
+                return false;
+            }
+
+            bool hasQ(Agent *, const std::vector<Value> &, const PredicateBind &)
+            {
+                return q;
+            }
+
+            bool hasR(Agent *, const std::vector<Value> &, const PredicateBind &)
+            {
+                return r;
+            }
+        }
+
         namespace actions
         {
             bool gather(
-                const Action &action,
+                const CompiledDomain &domain,
+                const CompiledAction &action,
                 const std::vector<PredicateBind> &binds,
                 const std::vector<std::size_t> &indices,
                 std::vector<Value> &values,
@@ -51,40 +94,46 @@ namespace ai
                 State &state
             )
             {
-                static const std::map<std::string, std::string> resourceMap
-                {
-                    { "wood", "tree" }, { "stone", "quarry" }
-                };
-
                 // Get first and only effect
                 std::size_t index = indices[0];
                 const PredicateBind &bind = binds[index];
 
-                if (bind.slots[0] == std::uint8_t(-1))
+                if (!bind.bound(0))
                     return false;
 
-                index = bind.slots[0];
-                auto it = resourceMap.find(values[index].value);
+                index = bind.slot(0);
+                const Symbol resource{ values[index].asSymbol() };
+                Symbol source;
 
-                if (it == resourceMap.end())
+                if (resource == symbols::wood)
+                    source = symbols::tree;
+                else if (resource == symbols::stone)
+                    source = symbols::quarry;
+                else
                     return false;
 
-                actionBind.slots[0] = static_cast<std::uint8_t>(values.size());
-                actionBind.slots[1] = static_cast<std::uint8_t>(index);
+                // New value has to fit slot
+                if (values.size() >= ActionBind::MaxValues)
+                    return false;
+
+                actionBind.setSlot(0, values.size());
+                actionBind.setSlot(1, index);
                 // TODO: add state to action binder and
                 // acquire all required types and cache values
-                values.push_back({ 0, (*it).second });
+                values.push_back(Value::symbol(0, source));
 
                 // Set resource exists false in initial state
                 state.set(bind, false);
 
-                for (std::size_t i = 0; i < action.preconditions.size(); ++i) {
-                    const Condition &precondition = action.preconditions[i];
-                    PredicateBind pred{ static_cast<std::uint8_t>(precondition.index) };
+                const CompiledCondition *preconditions = domain.preconditions(action);
 
-                    for (std::size_t i = 0; i < precondition.slots.size(); ++i) {
+                for (std::size_t i = 0; i < action.preconditions; ++i) {
+                    const CompiledCondition &precondition = preconditions[i];
+                    PredicateBind pred{ precondition.predicate };
+
+                    for (std::size_t i = 0; i < precondition.arity; ++i) {
                         const std::size_t ai = precondition.slots[i];
-                        pred.slots[i] = actionBind.slots[ai];
+                        pred.setSlot(i, actionBind.slot(ai));
                     }
 
                     state.set(pred, precondition.state);
@@ -93,6 +142,45 @@ namespace ai
                 return true;
             };
         }
+
+        // World of domain above without gathering, tables
+        // are checked and compiled together with program
+        struct StaticWorld
+        {
+            enum Types : std::uint32_t { Object };
+            enum Predicates : std::uint32_t { Exists, Near, Has, Inside };
+            enum Entities : std::uint64_t { Tree, Pile, Wood };
+
+            static constexpr const char *types[]{ "object" };
+
+            static constexpr StaticPredicate predicates[]{
+                { "exists", 1, { Object } },
+                { "near", 1, { Object } },
+                { "has", 1, { Object } },
+                { "inside", 2, { Object, Object } }
+            };
+
+            static constexpr StaticAction actions[]{
+                { "pickup", 1.0, 1, { Object }, 1, 1, false },
+                { "place", 1.0, 2, { Object, Object }, 2, 1, false }
+            };
+
+            static constexpr CompiledCondition conditions[]{
+                // pickup
+                { Exists, true, 1, { 0 } },
+                { Has, true, 1, { 0 } },
+                // place
+                { Has, true, 1, { 0 } },
+                { Exists, true, 1, { 1 } },
+                { Inside, true, 2, { 0, 1 } }
+            };
+
+            template<std::size_t Id>
+            static bool evaluate(Agent *, const std::vector<Value> &, const PredicateBind &)
+            {
+                return Id == Exists;
+            }
+        };
     }
 }
 
@@ -102,6 +190,12 @@ int main()
 
     Domain domain;
 
+    symbols::tree = domain.intern("tree");
+    symbols::pile = domain.intern("pile");
+    symbols::wood = domain.intern("wood");
+    symbols::stone = domain.intern("stone");
+    symbols::quarry = domain.intern("quarry");
+
     domain.addType("object");
 
     domain.addPredicate("exists", { "object" }, predicates::exists);
@@ -192,7 +286,11 @@ int main()
     */
 
     Planner planner{ domain };
-    planner.plan(goal);
+    Plan plan;
+    planner.plan(goal, plan);
+
+    const std::size_t allocations = planner.arena().allocations();
+    const std::size_t heap = heapAllocations();
 
     /*std::cout << "Plan: ";
 
@@ -204,9 +302,434 @@ int main()
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
     for (int i = 0; i < 10000; ++i)
-        planner.plan(goal);
+        planner.plan(goal, plan);
 
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 
     std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]" << std::endl;
+    std::cout << "Arena chunks after warm-up = " << planner.arena().allocations() - allocations << std::endl;
+    std::cout << "Heap allocations after warm-up = " << heapAllocations() - heap << std::endl;
+
+    // Names are resolved once, replanning only fills values
+    const GoalTemplate place = domain.goalTemplate(
+        {
+            { "what", "object" },
+            { "where", "object" }
+        },
+        {},
+        {
+            { "inside", { "what", "where" }, true }
+        }
+    );
+    const Symbol wood = domain.intern("wood");
+    const Symbol pile = domain.intern("pile");
+    Goal placeGoal;
+
+    // First instantiation sizes goal storage
+    place.instantiate(placeGoal, { wood, pile });
+    planner.plan(placeGoal, plan);
+    const std::size_t templateHeap = heapAllocations();
+
+    begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < 10000; ++i) {
+        place.instantiate(placeGoal, { wood, pile });
+        planner.plan(placeGoal, plan);
+    }
+
+    end = std::chrono::steady_clock::now();
+
+    std::cout << "Goal template: plan of " << plan.actions.size() << " actions, "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms], "
+        << heapAllocations() - templateHeap << " heap allocations" << std::endl;
+
+    const std::pair<HeuristicType, const char *> heuristics[]
+    {
+        { HeuristicType::GoalCount, "goal count" },
+        { HeuristicType::Max, "h_max" },
+        { HeuristicType::Add, "h_add" },
+        { HeuristicType::FF, "h_FF" }
+    };
+
+    for (const auto &heuristic : heuristics) {
+        planner.setHeuristic(heuristic.first);
+        planner.plan(goal, plan);
+
+        const SearchStatistics &statistics = planner.statistics();
+        std::cout << "Heuristic " << heuristic.second << ": " << plan.actions.size() << " actions, " << statistics.expanded << " expanded, " << statistics.generated << " generated" << std::endl;
+    }
+
+    planner.setHeuristic(HeuristicType::GoalCount);
+
+    // Report exists(wood) as changed, predicate still gives
+    // the same result so last search is reused as is
+    PredicateBind exists{ 0 };
+    exists.setSlot(0, 0);
+    const std::vector<PredicateBind> changed{ exists };
+    begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < 10000; ++i)
+        planner.replan(changed, plan);
+
+    end = std::chrono::steady_clock::now();
+
+    std::cout << "Replan time difference = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]" << std::endl;
+
+    // Replan after change which falsifies goal of last search
+    // must find the same plan as search from scratch
+    {
+        Domain relayDomain;
+        relayDomain.addType("object");
+        relayDomain.addPredicate("p", { "object" }, relay::p);
+        relayDomain.addPredicate("q", { "object" }, relay::hasQ);
+        relayDomain.addPredicate("r", { "object" }, relay::hasR);
+        relayDomain.addAction("a", 1.0, { { "o", "object" } }, { { "q", { "o" }, true } }, { { "p", { "o" }, true } });
+        relayDomain.addAction("b", 1.0, { { "o", "object" } }, { { "r", { "o" }, true } }, { { "q", { "o" }, true } });
+
+        const Goal relayGoal = relayDomain.goal({ { "o", "object", "box" } }, { { "p", { "o" }, true } });
+        PredicateBind q{ 1 }, r{ 2 };
+        q.setSlot(0, 0);
+        r.setSlot(0, 0);
+        bool same{ true };
+
+        for (const auto &heuristic : heuristics) {
+            relay::q = true;
+            relay::r = false;
+
+            Planner relayPlanner{ relayDomain };
+            relayPlanner.setHeuristic(heuristic.first);
+            Plan replanned, fresh;
+            relayPlanner.plan(relayGoal, replanned);
+
+            relay::q = false;
+            relay::r = true;
+            relayPlanner.replan({ q, r }, replanned);
+
+            Planner freshPlanner{ relayDomain };
+            freshPlanner.setHeuristic(heuristic.first);
+            freshPlanner.plan(relayGoal, fresh);
+
+            same = same && replanned.actions.size() == fresh.actions.size() && !fresh.actions.empty();
+        }
+
+        std::cout << "Replan after goal stopped holding: " << (same ? "same as fresh plan" : "differs from fresh plan") << std::endl;
+
+        // Successor which was a dead end before change
+        // must be found again once it becomes reachable
+        Domain deadEndDomain;
+        deadEndDomain.addType("object");
+        deadEndDomain.addPredicate("p", { "object" }, relay::p);
+        deadEndDomain.addPredicate("q", { "object" }, relay::hasQ);
+        deadEndDomain.addAction("a", 1.0, { { "o", "object" } }, { { "q", { "o" }, true } }, { { "p", { "o" }, true } });
+
+        const Goal deadEndGoal = deadEndDomain.goal({ { "o", "object", "box" } }, { { "p", { "o" }, true } });
+        same = true;
+
+        for (const auto &heuristic : heuristics) {
+            relay::q = false;
+
+            Planner deadEndPlanner{ deadEndDomain };
+            deadEndPlanner.setHeuristic(heuristic.first);
+            Plan replanned, fresh;
+            deadEndPlanner.plan(deadEndGoal, replanned);
+
+            relay::q = true;
+            deadEndPlanner.replan({ q }, replanned);
+
+            Planner freshPlanner{ deadEndDomain };
+            freshPlanner.setHeuristic(heuristic.first);
+            freshPlanner.plan(deadEndGoal, fresh);
+
+            same = same && replanned.actions.size() == fresh.actions.size() && !fresh.actions.empty();
+        }
+
+        std::cout << "Replan after dead end became reachable: " << (same ? "same as fresh plan" : "differs from fresh plan") << std::endl;
+    }
+
+    // World doesn't change, so every plan after the first one is a hit
+    PlanCache cache;
+    planner.setPlanCache(&cache);
+    begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < 10000; ++i)
+        planner.plan(goal, plan);
+
+    end = std::chrono::steady_clock::now();
+    planner.setPlanCache(nullptr);
+
+    std::cout << "Cached time difference = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms], " << cache.hits() << " hits" << std::endl;
+
+    // Weighted search gives plan early, each call to improve
+    // continues it within few expansions and lowers the bound
+    SearchLimits limits;
+    limits.expansions = 2;
+    limits.weight = 3.0;
+    planner.setHeuristic(HeuristicType::Max);
+    planner.setLimits(limits);
+    bool found = planner.plan(goal, plan);
+    int slices{ 1 };
+
+    while (planner.statistics().exhausted || (found && planner.statistics().bound > 1.0)) {
+        found = planner.improve(plan);
+        ++slices;
+    }
+
+    std::cout << "Anytime: " << (found ? plan.actions.size() : 0) << " actions, cost " << planner.statistics().cost << " in " << slices << " slices" << std::endl;
+
+    planner.setLimits({});
+    planner.setHeuristic(HeuristicType::GoalCount);
+
+#if GOAP_INSTRUMENTATION
+    // Spans of few plans, open trace.json in Perfetto
+    {
+        std::ofstream file{ "trace.json" };
+        ChromeTrace trace{ file };
+        planner.setTraceSink(&trace);
+
+        for (int i = 0; i < 10; ++i)
+            planner.plan(goal, plan);
+
+        planner.setTraceSink(nullptr);
+    }
+
+    const SearchProfile &profile = planner.profile();
+    std::cout << "Profile: " << profile.combinations << " combinations, " << profile.bindRejections << " rejected, "
+        << profile.openHits + profile.closedHits << " duplicates, " << profile.peakNodeBytes << " node bytes" << std::endl;
+
+    for (std::size_t i = 0; i < profile.binds.size(); ++i) {
+        if (profile.binds[i].calls != 0)
+            std::cout << "  " << planner.domain().actionName(i) << ": " << profile.binds[i].calls << " binds, " << profile.binds[i].time.count() << "[ns]" << std::endl;
+    }
+#endif
+
+    // Searches of many agents interleaved on one thread,
+    // each frame gives every task a couple of expansions
+    std::vector<std::unique_ptr<PlanningTask>> tasks;
+
+    for (int i = 0; i < 100; ++i)
+        tasks.push_back(std::make_unique<PlanningTask>(domain, goal));
+
+    std::size_t pending{ tasks.size() };
+    int frames{ 0 };
+
+    while (pending != 0) {
+        pending = 0;
+
+        for (auto &task : tasks) {
+            if ((*task).step(2) == TaskStatus::InProgress)
+                ++pending;
+        }
+
+        ++frames;
+    }
+
+    std::cout << "Tasks: " << tasks.size() << " plans of " << (*tasks[0]).plan().actions.size() << " actions in " << frames << " frames" << std::endl;
+
+    // Requests of gameplay are answered by futures, every
+    // agent replans twice so its first request is superseded
+    {
+        PlanningService service{ domain };
+        std::vector<Agent *> agents(1000);
+        std::vector<PlanningService::Handle> handles;
+
+        for (int pass = 0; pass < 2; ++pass) {
+            for (auto &agent : agents) {
+                ServiceRequest request{ &goal };
+                request.agent = reinterpret_cast<Agent *>(&agent);
+                request.priority = pass;
+                handles.push_back(service.submit(request));
+            }
+        }
+
+        for (const auto &handle : handles)
+            handle.wait();
+
+        const ServiceStatistics statistics = service.statistics();
+        std::cout << "Service: " << statistics.found << " found, " << statistics.cancelled << " superseded, peak depth " << statistics.peakDepth << ", mean wait " << statistics.wait.count() / std::max<std::size_t>(statistics.found, 1) << "[us] on " << service.threads() << " threads" << std::endl;
+    }
+
+    // Same goal replicated across many agents
+    std::vector<PlanRequest> requests(10000, { nullptr, &goal });
+    std::vector<Plan> results(requests.size());
+    BatchPlanner batch{ domain };
+    batch.plan(requests.data(), requests.size(), results.data());
+
+    begin = std::chrono::steady_clock::now();
+    batch.plan(requests.data(), requests.size(), results.data());
+    end = std::chrono::steady_clock::now();
+
+    std::cout << "Batch time difference = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms] on " << batch.threads() << " threads" << std::endl;
+
+    // One goal searched by all threads
+    ParallelPlanner parallel{ domain };
+    parallel.plan(goal, plan);
+
+    begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < 1000; ++i)
+        parallel.plan(goal, plan);
+
+    end = std::chrono::steady_clock::now();
+
+    std::cout << "Parallel time difference = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms] on " << parallel.threads() << " threads" << std::endl;
+
+    // Behaviour is patched while another thread keeps planning,
+    // every plan sees either old or new domain as a whole
+    std::atomic<bool> patching{ true };
+    std::atomic<std::size_t> livePlans{ 0 };
+    std::atomic<std::size_t> liveFound{ 0 };
+    std::thread live{ [&domain, &goal, &patching, &livePlans, &liveFound] {
+        Planner planner{ domain };
+        Plan plan;
+        Goal liveGoal = goal;
+
+        while (patching) {
+            // Removal shifts ids, goal is made again for new epoch
+            if (liveGoal.epoch != domain.epoch()) {
+                liveGoal = domain.goal(
+                    {
+                        { "what", "object", "wood" },
+                        { "where", "object", "pile" }
+                    },
+                    {
+                        { "inside", { "what", "where" }, true }
+                    }
+                );
+            }
+
+            if (planner.plan(liveGoal, plan))
+                ++liveFound;
+
+            ++livePlans;
+        }
+    } };
+
+    while (livePlans == 0)
+        std::this_thread::yield();
+
+    for (int i = 0; i < 100; ++i) {
+        domain.removeAction("pickup");
+        domain.addAction(
+            "pickup",
+            1.0,
+            {
+                { "what", "object" }
+            },
+            {
+                { "exists", { "what" }, true }
+            },
+            {
+                { "has", { "what" }, true }
+            }
+        );
+    }
+
+    patching = false;
+    live.join();
+
+    std::cout << "Hot patch: " << livePlans << " plans, " << liveFound << " found during 200 domain changes" << std::endl;
+
+    // Static domain needs no names, goal refers to spec ids
+    Planner staticPlanner{ StaticDomain<StaticWorld>::compiled() };
+    const Goal staticGoal = StaticDomain<StaticWorld>::goal(
+        {
+            Value::entity(StaticWorld::Object, StaticWorld::Wood),
+            Value::entity(StaticWorld::Object, StaticWorld::Pile)
+        },
+        {
+            { StaticWorld::Inside, true, 2, { 0, 1 } }
+        }
+    );
+
+    staticPlanner.plan(staticGoal, plan);
+    begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < 10000; ++i)
+        staticPlanner.plan(staticGoal, plan);
+
+    end = std::chrono::steady_clock::now();
+
+    // Same tables seed runtime domain, dynamic parts go on top of them
+    Domain mixed;
+    StaticDomain<StaticWorld>::install(mixed);
+    Planner mixedPlanner{ mixed };
+    Plan mixedPlan;
+    mixedPlanner.plan(staticGoal, mixedPlan);
+
+    std::cout << "Static domain: " << plan.actions.size() << " actions, 10000 plans in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms], installed "
+        << mixedPlan.actions.size() << " actions" << std::endl;
+
+    // Unknown facts of every expansion reach batch predicates
+    // together, search itself doesn't change
+    GeneratorParams batchParams;
+    batchParams.batch = true;
+    Generator batchWorld{ batchParams };
+    Domain batchDomain;
+    batchWorld.build(batchDomain);
+
+    Planner batchPlanner{ batchDomain };
+    Plan batchPlan;
+    batchPlanner.plan(batchWorld.goal(batchDomain, 0), batchPlan, &batchWorld);
+
+    std::cout << "Batched predicates: " << batchPlan.actions.size() << " actions, "
+        << batchPlanner.statistics().expanded << " expanded" << std::endl;
+
+    // Domain text refers to callbacks by name, its image
+    // is mapped at startup and used without parsing
+    CallbackRegistry registry;
+    registry.add("exists", predicates::exists);
+    registry.add("near", predicates::near);
+    registry.add("has", predicates::has);
+    registry.add("inside", predicates::inside);
+    registry.add("gather", actions::gather);
+
+    std::istringstream text{
+        "type object\n"
+        "predicate exists object\n"
+        "predicate near object\n"
+        "predicate has object\n"
+        "predicate inside object object\n"
+        "action pickup 1 what:object\n"
+        "    pre exists what\n"
+        "    eff has what\n"
+        "action gather 1 source:object resource:object @gather\n"
+        "    pre exists source\n"
+        "    eff exists resource\n"
+        "action place 1 what:object where:object\n"
+        "    pre has what\n"
+        "    pre exists where\n"
+        "    eff inside what where\n"
+    };
+
+    Domain loaded;
+    DomainLoader loader{ registry };
+    DomainImage image{ registry };
+
+    // Same order as domain above, so predicates see the same symbols
+    for (const char *name : { "tree", "pile", "wood", "stone", "quarry" })
+        image.intern(name);
+
+    if (!loader.load(text, loaded))
+        std::cout << loader.error() << std::endl;
+    else if (!image.writeFile(loaded, "domain.img") || !image.open("domain.img"))
+        std::cout << image.error() << std::endl;
+    else {
+        const Goal imageGoal = image.goal(
+            {
+                { "what", "object", "wood" },
+                { "where", "object", "pile" }
+            },
+            {
+                { "inside", { "what", "where" }, true }
+            }
+        );
+
+        Planner imagePlanner{ image.domain() };
+        Plan imagePlan;
+        imagePlanner.plan(imageGoal, imagePlan);
+
+        std::cout << "Domain image: " << (*image.domain()).actionCount() << " actions loaded, plan of "
+            << imagePlan.actions.size() << " actions" << std::endl;
+    }
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "predicate.h"
+#include "bind.h"
+
 #include <string>
 #include <vector>
 
@@ -36,12 +39,18 @@ namespace ai
             }*/
         };
 
-        struct Action;
-        union ActionBind;
         class State;
+        class CompiledDomain;
+        struct CompiledAction;
+        struct ActionTag;
+
+        // Action id with indices of values of its arguments
+        using ActionBind = BasicBind<GOAP_ACTION_BITS, GOAP_VALUE_BITS, ActionTag>;
 
+        // Conditions of action are read from snapshot, see CompiledDomain::preconditions
         using BindFunc = bool(*)(
-            const Action &,
+            const CompiledDomain &,
+            const CompiledAction &,
             const std::vector<PredicateBind> &,
             const std::vector<std::size_t> &,
             std::vector<Value> &,
@@ -58,26 +67,5 @@ namespace ai
             std::vector<Condition> effects;
             BindFunc bindFunc;
         };
-
-        union ActionBind
-        {
-            struct
-            {
-                std::uint8_t id;
-                std::uint8_t slots[7];
-            };
-            std::uint64_t data;
-
-            ActionBind() :
-                data{ std::size_t(-1) }
-            {
-            }
-
-            ActionBind(const std::uint8_t aid) :
-                data{ std::size_t(-1) }
-            {
-                id = aid;
-            }
-        };
     }
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::size_t> allocations{ 0 };
+}
+
+void *operator new(std::size_t size)
+{
+    ++allocations;
+
+    if (void *memory = std::malloc(size != 0 ? size : 1))
+        return memory;
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace ai
+{
+    namespace goap
+    {
+        std::size_t heapAllocations()
+        {
+            return allocations;
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Calls of global operator new since start. Counter replaces
+        // global allocation functions, so it is opt-in and only
+        // executables linking allocationcounter.cpp have it
+        std::size_t heapAllocations();
+    }
+}
@@ -0,0 +1,95 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ai
+{
+    namespace goap
+    {
+        Arena::Arena(std::pmr::memory_resource *upstream) :
+            _upstream{ upstream },
+            _chunk{ 0 },
+            _offset{ 0 },
+            _used{ 0 },
+            _peak{ 0 },
+            _allocations{ 0 }
+        {
+        }
+
+        Arena::Arena(void *buffer, std::size_t size, std::pmr::memory_resource *upstream) :
+            Arena(upstream)
+        {
+            setBuffer(buffer, size);
+        }
+
+        Arena::~Arena()
+        {
+            for (const auto &chunk : _chunks) {
+                if (chunk.owned)
+                    _upstream->deallocate(chunk.data, chunk.size, alignof(std::max_align_t));
+            }
+        }
+
+        void Arena::setBuffer(void *buffer, std::size_t size)
+        {
+            const auto it = std::find_if(_chunks.begin(), _chunks.end(), [](const Chunk &chunk) {
+                return !chunk.owned;
+            });
+
+            if (it != _chunks.end())
+                _chunks.erase(it);
+
+            if (buffer != nullptr && size > 0)
+                _chunks.insert(_chunks.begin(), { static_cast<char *>(buffer), size, false });
+
+            reset();
+        }
+
+        void Arena::reset()
+        {
+            _chunk = 0;
+            _offset = 0;
+            _used = 0;
+        }
+
+        std::size_t Arena::capacity() const
+        {
+            std::size_t result{ 0 };
+
+            for (const auto &chunk : _chunks)
+                result += chunk.size;
+
+            return result;
+        }
+
+        void *Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+        {
+            // Try current chunk and then chunks kept from previous runs
+            while (_chunk < _chunks.size()) {
+                const Chunk &chunk = _chunks[_chunk];
+                const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk.data);
+                const std::uintptr_t aligned = (base + _offset + alignment - 1) & ~std::uintptr_t(alignment - 1);
+                const std::size_t end = static_cast<std::size_t>(aligned - base) + bytes;
+
+                if (end <= chunk.size) {
+                    _used += end - _offset;
+                    _peak = std::max(_peak, _used);
+                    _offset = end;
+                    return reinterpret_cast<void *>(aligned);
+                }
+
+                ++_chunk;
+                _offset = 0;
+            }
+
+            const std::size_t last = _chunks.empty() ? 0 : _chunks.back().size;
+            const std::size_t size = std::max({ MinChunkSize, last * 2, bytes + alignment });
+            char *data = static_cast<char *>(_upstream->allocate(size, alignof(std::max_align_t)));
+            _chunks.push_back({ data, size, true });
+            ++_allocations;
+
+            return do_allocate(bytes, alignment);
+        }
+    }
+}
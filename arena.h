@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Monotonic arena which keeps its chunks between resets,
+        // so after warm-up it never goes to upstream resource
+        class Arena : public std::pmr::memory_resource
+        {
+        public:
+            Arena(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+            Arena(void *buffer, std::size_t size, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+            Arena(const Arena &) = delete;
+            Arena &operator=(const Arena &) = delete;
+            ~Arena();
+
+            // Buffer is not owned and used before any upstream memory,
+            // only valid to change while nothing is allocated
+            void setBuffer(void *buffer, std::size_t size);
+            void setUpstream(std::pmr::memory_resource *upstream) { _upstream = upstream; }
+
+            void reset();
+
+            // Number of chunks requested from upstream resource
+            std::size_t allocations() const { return _allocations; }
+            std::size_t capacity() const;
+            std::size_t used() const { return _used; }
+            std::size_t peak() const { return _peak; }
+
+        protected:
+            void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+            void do_deallocate(void *, std::size_t, std::size_t) override {}
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+            {
+                return this == &other;
+            }
+
+        private:
+            struct Chunk
+            {
+                char *data;
+                std::size_t size;
+                bool owned;
+            };
+
+        private:
+            static constexpr std::size_t MinChunkSize = 64 * 1024;
+
+            std::pmr::memory_resource *_upstream;
+            std::vector<Chunk> _chunks;
+            std::size_t _chunk;
+            std::size_t _offset;
+            std::size_t _used;
+            std::size_t _peak;
+            std::size_t _allocations;
+
+        };
+    }
+}
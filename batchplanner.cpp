@@ -0,0 +1,172 @@
+#include "batchplanner.h"
+
+#include <algorithm>
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            std::uint64_t pack(const std::uint64_t begin, const std::uint64_t end)
+            {
+                return begin | (end << 32);
+            }
+
+            std::size_t begin(const std::uint64_t range)
+            {
+                return static_cast<std::size_t>(range & 0xFFFFFFFFull);
+            }
+
+            std::size_t end(const std::uint64_t range)
+            {
+                return static_cast<std::size_t>(range >> 32);
+            }
+        }
+
+        BatchPlanner::BatchPlanner(const Domain &domain, std::size_t threads) :
+            _generation{ 0 },
+            _active{ 0 },
+            _stop{ false },
+            _requests{ nullptr },
+            _results{ nullptr },
+            _found{ 0 }
+        {
+            threads = std::max<std::size_t>(threads, 1);
+
+            for (std::size_t i = 0; i < threads; ++i)
+                _workers.push_back(std::make_unique<Worker>(domain));
+
+            // First worker is the calling thread
+            for (std::size_t i = 1; i < threads; ++i)
+                (*_workers[i]).thread = std::thread{ &BatchPlanner::run, this, i };
+        }
+
+        BatchPlanner::~BatchPlanner()
+        {
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                _stop = true;
+            }
+
+            _start.notify_all();
+
+            for (auto &worker : _workers) {
+                if ((*worker).thread.joinable())
+                    (*worker).thread.join();
+            }
+        }
+
+        std::size_t BatchPlanner::plan(const PlanRequest *requests, std::size_t count, Plan *results)
+        {
+            if (count == 0)
+                return 0;
+
+            const std::size_t threads = _workers.size();
+            _requests = requests;
+            _results = results;
+            _found = 0;
+
+            // Split evenly, stealing will balance the rest
+            for (std::size_t i = 0; i < threads; ++i) {
+                const std::size_t first = count * i / threads;
+                const std::size_t last = count * (i + 1) / threads;
+                (*_workers[i]).range.store(pack(first, last), std::memory_order_relaxed);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                _active = threads - 1;
+                ++_generation;
+            }
+
+            _start.notify_all();
+            work(0);
+
+            std::unique_lock<std::mutex> lock{ _mutex };
+            _done.wait(lock, [this] { return _active == 0; });
+
+            return _found;
+        }
+
+        void BatchPlanner::run(const std::size_t worker)
+        {
+            std::size_t generation{ 0 };
+
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock{ _mutex };
+                    _start.wait(lock, [this, generation] { return _stop || _generation != generation; });
+
+                    if (_stop)
+                        return;
+
+                    generation = _generation;
+                }
+
+                work(worker);
+
+                std::lock_guard<std::mutex> lock{ _mutex };
+
+                if (--_active == 0)
+                    _done.notify_one();
+            }
+        }
+
+        void BatchPlanner::work(const std::size_t worker)
+        {
+            Worker &self = *_workers[worker];
+            std::size_t found{ 0 };
+            std::size_t index;
+
+            while (pop(self, index) || steal(worker, index)) {
+                const PlanRequest &request = _requests[index];
+
+                if (self.planner.plan(*request.goal, _results[index], request.agent))
+                    ++found;
+            }
+
+            _found += found;
+        }
+
+        bool BatchPlanner::pop(Worker &worker, std::size_t &index)
+        {
+            std::uint64_t range = worker.range.load(std::memory_order_acquire);
+
+            while (begin(range) < end(range)) {
+                const std::uint64_t next = pack(begin(range) + 1, end(range));
+
+                if (worker.range.compare_exchange_weak(range, next, std::memory_order_acq_rel)) {
+                    index = begin(range);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool BatchPlanner::steal(const std::size_t thief, std::size_t &index)
+        {
+            const std::size_t threads = _workers.size();
+
+            for (std::size_t i = 1; i < threads; ++i) {
+                Worker &victim = *_workers[(thief + i) % threads];
+                std::uint64_t range = victim.range.load(std::memory_order_acquire);
+
+                while (begin(range) < end(range)) {
+                    // Take upper half, at least one request
+                    const std::size_t middle = begin(range) + (end(range) - begin(range)) / 2;
+
+                    if (victim.range.compare_exchange_weak(range, pack(begin(range), middle), std::memory_order_acq_rel)) {
+                        const std::size_t last = end(range);
+                        index = middle;
+                        (*_workers[thief]).range.store(pack(middle + 1, last), std::memory_order_release);
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "planner.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ai
+{
+    namespace goap
+    {
+        struct PlanRequest
+        {
+            Agent *agent;
+            const Goal *goal;
+        };
+
+        // Plans many requests in parallel against one shared domain.
+        // Every worker owns a planner so its scratch is reused between
+        // batches, idle workers steal half of remaining requests from
+        // busy ones. Predicates and bind functions must be thread safe
+        class BatchPlanner
+        {
+        public:
+            BatchPlanner(const Domain &domain, std::size_t threads = std::thread::hardware_concurrency());
+            BatchPlanner(const BatchPlanner &) = delete;
+            BatchPlanner &operator=(const BatchPlanner &) = delete;
+            ~BatchPlanner();
+
+            // Calling thread takes part as the first worker. Result of
+            // requests[i] is written to results[i], returns found plans count
+            std::size_t plan(const PlanRequest *requests, std::size_t count, Plan *results);
+
+            std::size_t threads() const { return _workers.size(); }
+            Planner &planner(const std::size_t worker) { return (*_workers[worker]).planner; }
+
+        private:
+            struct Worker
+            {
+                Worker(const Domain &domain) :
+                    planner{ domain },
+                    range{ 0 }
+                {
+                }
+
+                Planner planner;
+                // Remaining requests, begin in low and end in high half
+                std::atomic<std::uint64_t> range;
+                std::thread thread;
+            };
+
+        private:
+            void run(const std::size_t worker);
+            void work(const std::size_t worker);
+            bool pop(Worker &worker, std::size_t &index);
+            bool steal(const std::size_t thief, std::size_t &index);
+
+        private:
+            std::vector<std::unique_ptr<Worker>> _workers;
+            std::mutex _mutex;
+            std::condition_variable _start;
+            std::condition_variable _done;
+            std::size_t _generation;
+            std::size_t _active;
+            bool _stop;
+            const PlanRequest *_requests;
+            Plan *_results;
+            std::atomic<std::size_t> _found;
+
+        };
+    }
+}
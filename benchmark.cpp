@@ -0,0 +1,325 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include "domain.h"
+#include "planner.h"
+#include "generator.h"
+
+// Runs planner over generated domains and writes one csv row per
+// scenario to stdout, so runs of two builds can be compared:
+//   benchmark --iterations 50 > base.csv
+//   benchmark --baseline base.csv > new.csv
+
+namespace
+{
+    using namespace ai::goap;
+
+    struct Scenario
+    {
+        std::string name;
+        GeneratorParams params;
+    };
+
+    struct Options
+    {
+        std::size_t goals = 16;
+        std::size_t iterations = 20;
+        std::string filter;
+        std::string baseline;
+        HeuristicType heuristic = HeuristicType::GoalCount;
+        OpenListType openList = OpenListType::BinaryHeap;
+        NodeStorage storage = NodeStorage::Full;
+        bool batch = false;
+    };
+
+    struct Row
+    {
+        double p50;
+        double p99;
+        double rate;
+    };
+
+    double percentile(const std::vector<double> &sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        const std::size_t index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+
+    // Each sweep changes one parameter of base scenario, larger
+    // domains need wider bind layout, see GOAP_ACTION_BITS
+    std::vector<Scenario> scenarios()
+    {
+        std::vector<Scenario> result;
+        const GeneratorParams base;
+
+        result.push_back({ "base", base });
+
+        for (const std::size_t depth : { 2, 6, 8 }) {
+            GeneratorParams params{ base };
+            params.depth = depth;
+            result.push_back({ "depth=" + std::to_string(depth), params });
+        }
+
+        for (const std::size_t branching : { 1, 6 }) {
+            GeneratorParams params{ base };
+            params.branching = branching;
+            result.push_back({ "branching=" + std::to_string(branching), params });
+        }
+
+        for (const std::size_t width : { 2, 16 }) {
+            GeneratorParams params{ base };
+            params.width = width;
+            result.push_back({ "width=" + std::to_string(width), params });
+        }
+
+        for (const std::size_t arity : { 0, 1, 3 }) {
+            GeneratorParams params{ base };
+            params.arity = arity;
+            result.push_back({ "arity=" + std::to_string(arity), params });
+        }
+
+        for (const std::size_t values : { 1, 16, 64 }) {
+            GeneratorParams params{ base };
+            params.values = values;
+            result.push_back({ "values=" + std::to_string(values), params });
+        }
+
+        for (const std::size_t types : { 1, 4 }) {
+            GeneratorParams params{ base };
+            params.types = types;
+            result.push_back({ "types=" + std::to_string(types), params });
+        }
+
+        for (const std::size_t preconditions : { 2, 3 }) {
+            GeneratorParams params{ base };
+            params.preconditions = preconditions;
+            result.push_back({ "preconditions=" + std::to_string(preconditions), params });
+        }
+
+        for (const std::size_t goalFacts : { 1, 4 }) {
+            GeneratorParams params{ base };
+            params.goalFacts = goalFacts;
+            result.push_back({ "goals=" + std::to_string(goalFacts), params });
+        }
+
+        return result;
+    }
+
+    std::unordered_map<std::string, Row> load(const std::string &path)
+    {
+        std::unordered_map<std::string, Row> rows;
+        std::ifstream file{ path };
+        std::string line;
+
+        // Header names columns, so baseline may come from older build
+        if (!std::getline(file, line))
+            return rows;
+
+        std::vector<std::string> header;
+        std::stringstream columns{ line };
+        std::string column;
+
+        while (std::getline(columns, column, ','))
+            header.push_back(column);
+
+        while (std::getline(file, line)) {
+            std::stringstream cells{ line };
+            std::string cell;
+            std::string name;
+            Row row{ 0.0, 0.0, 0.0 };
+
+            for (std::size_t i = 0; i < header.size() && std::getline(cells, cell, ','); ++i) {
+                if (header[i] == "scenario")
+                    name = cell;
+                else if (header[i] == "p50_us")
+                    row.p50 = std::atof(cell.c_str());
+                else if (header[i] == "p99_us")
+                    row.p99 = std::atof(cell.c_str());
+                else if (header[i] == "expansions_per_s")
+                    row.rate = std::atof(cell.c_str());
+            }
+
+            rows[name] = row;
+        }
+
+        return rows;
+    }
+
+    bool parse(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i < argc; ++i) {
+            const char *arg = argv[i];
+            const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+            if (value == nullptr) {
+                std::cerr << "Missing value of " << arg << std::endl;
+                return false;
+            }
+
+            if (std::strcmp(arg, "--goals") == 0)
+                options.goals = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(arg, "--iterations") == 0)
+                options.iterations = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(arg, "--filter") == 0)
+                options.filter = value;
+            else if (std::strcmp(arg, "--baseline") == 0)
+                options.baseline = value;
+            else if (std::strcmp(arg, "--heuristic") == 0) {
+                const std::pair<const char *, HeuristicType> names[]{
+                    { "count", HeuristicType::GoalCount },
+                    { "max", HeuristicType::Max },
+                    { "add", HeuristicType::Add },
+                    { "ff", HeuristicType::FF }
+                };
+                const auto it = std::find_if(std::begin(names), std::end(names), [value](const auto &name) {
+                    return std::strcmp(name.first, value) == 0;
+                });
+
+                if (it == std::end(names)) {
+                    std::cerr << "Unknown heuristic " << value << std::endl;
+                    return false;
+                }
+
+                options.heuristic = (*it).second;
+            } else if (std::strcmp(arg, "--open") == 0) {
+                if (std::strcmp(value, "binary") == 0)
+                    options.openList = OpenListType::BinaryHeap;
+                else if (std::strcmp(value, "quaternary") == 0)
+                    options.openList = OpenListType::QuaternaryHeap;
+                else if (std::strcmp(value, "bucket") == 0)
+                    options.openList = OpenListType::Bucket;
+                else {
+                    std::cerr << "Unknown open list " << value << std::endl;
+                    return false;
+                }
+            } else if (std::strcmp(arg, "--storage") == 0) {
+                options.storage = std::strcmp(value, "delta") == 0 ? NodeStorage::Delta : NodeStorage::Full;
+            } else if (std::strcmp(arg, "--predicates") == 0) {
+                options.batch = std::strcmp(value, "batch") == 0;
+            } else {
+                std::cerr << "Unknown option " << arg << std::endl;
+                return false;
+            }
+
+            ++i;
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    if (!parse(argc, argv, options)) {
+        std::cerr << "Usage: benchmark [--goals n] [--iterations n] [--filter text] [--baseline file.csv]"
+            " [--heuristic count|max|add|ff] [--open binary|quaternary|bucket] [--storage full|delta]"
+            " [--predicates single|batch]" << std::endl;
+        return 1;
+    }
+
+    const auto baseline = options.baseline.empty() ? std::unordered_map<std::string, Row>{} : load(options.baseline);
+
+    std::cout << "scenario,types,width,depth,branching,arity,values,preconditions,goal_facts,predicates,actions,"
+        "plans,found,mean_actions,p50_us,p90_us,p99_us,max_us,mean_us,expanded,generated,expansions_per_s,"
+        "max_generated,planner_memory_kb" << std::endl;
+
+    for (const auto &scenario : scenarios()) {
+        if (!options.filter.empty() && scenario.name.find(options.filter) == std::string::npos)
+            continue;
+
+        GeneratorParams params{ scenario.params };
+        params.batch = options.batch;
+        Generator generator{ params };
+        Domain domain;
+
+        if (!generator.build(domain)) {
+            std::cerr << scenario.name << ": " << domain.error() << std::endl;
+            continue;
+        }
+
+        std::vector<Goal> goals;
+
+        for (std::size_t i = 0; i < options.goals; ++i)
+            goals.push_back(generator.goal(domain, i));
+
+        Planner planner{ domain, options.openList };
+        planner.setHeuristic(options.heuristic);
+        planner.setNodeStorage(options.storage);
+        Plan plan;
+
+        // Warm up arena and node storage
+        for (const auto &goal : goals)
+            planner.plan(goal, plan, &generator);
+
+        std::vector<double> latencies;
+        latencies.reserve(goals.size() * options.iterations);
+        std::size_t found{ 0 };
+        std::size_t actions{ 0 };
+        std::size_t expanded{ 0 };
+        std::size_t generated{ 0 };
+        std::size_t maxGenerated{ 0 };
+        // Process high-water mark never drops, so memory
+        // of this scenario's planner is reported instead
+        std::size_t memory{ 0 };
+        double total{ 0.0 };
+
+        for (std::size_t i = 0; i < options.iterations; ++i) {
+            for (const auto &goal : goals) {
+                const auto begin = std::chrono::steady_clock::now();
+                const bool result = planner.plan(goal, plan, &generator);
+                const auto end = std::chrono::steady_clock::now();
+
+                const double us = std::chrono::duration<double, std::micro>(end - begin).count();
+                latencies.push_back(us);
+                total += us;
+
+                if (result) {
+                    ++found;
+                    actions += plan.actions.size();
+                }
+
+                expanded += planner.statistics().expanded;
+                generated += planner.statistics().generated;
+                maxGenerated = std::max(maxGenerated, planner.statistics().generated);
+                memory = std::max(memory, planner.memory());
+            }
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        const std::size_t plans{ latencies.size() };
+        const double rate = total > 0.0 ? expanded / (total / 1e6) : 0.0;
+
+        std::cout << scenario.name << ',' << params.types << ',' << params.width << ',' << params.depth << ','
+            << params.branching << ',' << params.arity << ',' << params.values << ',' << params.preconditions << ','
+            << params.goalFacts << ',' << generator.predicateCount() << ',' << generator.actionCount() << ','
+            << plans << ',' << found << ',' << (found != 0 ? double(actions) / found : 0.0) << ','
+            << percentile(latencies, 0.5) << ',' << percentile(latencies, 0.9) << ',' << percentile(latencies, 0.99) << ','
+            << (plans != 0 ? latencies.back() : 0.0) << ',' << (plans != 0 ? total / plans : 0.0) << ','
+            << (plans != 0 ? expanded / plans : 0) << ',' << (plans != 0 ? generated / plans : 0) << ','
+            << std::size_t(rate) << ',' << maxGenerated << ',' << memory / 1024 << std::endl;
+
+        // Comparison goes to stderr, so stdout stays a valid csv
+        const auto it = baseline.find(scenario.name);
+
+        if (it != baseline.end() && (*it).second.p50 > 0.0 && (*it).second.p99 > 0.0) {
+            const Row &base = (*it).second;
+            std::cerr << scenario.name << ": p50 " << percentile(latencies, 0.5) / base.p50
+                << "x, p99 " << percentile(latencies, 0.99) / base.p99
+                << "x, expansions/s " << (base.rate > 0.0 ? rate / base.rate : 0.0) << "x of baseline" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// Bit widths of packed binds, override to trade slots for range.
+// Every bind stays one 64 bit word, so states, hashing and equality
+// don't depend on chosen layout. Defaults give 255 predicates,
+// 255 actions, 255 values and 7 slots, for example 12/12/13 gives
+// 4095 predicates and actions, 8191 values and 4 slots
+#ifndef GOAP_PREDICATE_BITS
+#define GOAP_PREDICATE_BITS 8
+#endif
+
+#ifndef GOAP_ACTION_BITS
+#define GOAP_ACTION_BITS 8
+#endif
+
+#ifndef GOAP_VALUE_BITS
+#define GOAP_VALUE_BITS 8
+#endif
+
+namespace ai
+{
+    namespace goap
+    {
+        // Id is stored in lowest bits followed by slots, unused high
+        // bits are set. Id or slot with all bits set is unbound
+        template<std::size_t IdBits, std::size_t SlotBits, typename Tag>
+        struct BasicBind
+        {
+            static_assert(IdBits > 0 && SlotBits > 0 && IdBits + SlotBits <= 64, "Bind doesn't fit 64 bits");
+
+            static constexpr std::size_t Bits = IdBits;
+            static constexpr std::size_t Arity = (64 - IdBits) / SlotBits;
+            static constexpr std::uint64_t IdMask = (std::uint64_t(1) << IdBits) - 1;
+            static constexpr std::uint64_t SlotMask = (std::uint64_t(1) << SlotBits) - 1;
+            // Number of usable ids and slot values
+            static constexpr std::size_t MaxIds = std::size_t(IdMask);
+            static constexpr std::size_t MaxValues = std::size_t(SlotMask);
+            static constexpr std::size_t Unbound = std::size_t(SlotMask);
+
+            std::uint64_t data;
+
+            BasicBind() :
+                data{ std::uint64_t(-1) }
+            {
+            }
+
+            BasicBind(const std::size_t bid) :
+                data{ ~IdMask | (std::uint64_t(bid) & IdMask) }
+            {
+            }
+
+            std::size_t id() const { return std::size_t(data & IdMask); }
+
+            std::size_t slot(const std::size_t i) const
+            {
+                return std::size_t((data >> (IdBits + i * SlotBits)) & SlotMask);
+            }
+
+            void setSlot(const std::size_t i, const std::size_t value)
+            {
+                const std::size_t shift = IdBits + i * SlotBits;
+                data = (data & ~(SlotMask << shift)) | ((std::uint64_t(value) & SlotMask) << shift);
+            }
+
+            bool bound(const std::size_t i) const { return slot(i) != Unbound; }
+
+            bool operator==(const BasicBind &other) const
+            {
+                return data == other.data;
+            }
+
+            bool operator!=(const BasicBind &other) const
+            {
+                return data != other.data;
+            }
+        };
+    }
+}
+
+namespace std
+{
+    template<std::size_t IdBits, std::size_t SlotBits, typename Tag>
+    struct hash<ai::goap::BasicBind<IdBits, SlotBits, Tag>>
+    {
+        std::size_t operator()(ai::goap::BasicBind<IdBits, SlotBits, Tag> const &token) const noexcept
+        {
+            return std::hash<std::uint64_t>{}(token.data);
+        }
+    };
+}
@@ -0,0 +1,71 @@
+#include "callbackregistry.h"
+
+namespace ai
+{
+    namespace goap
+    {
+        void CallbackRegistry::add(const std::string &name, PredicateFunc func)
+        {
+            _predicates[name] = { func, nullptr };
+        }
+
+        void CallbackRegistry::add(const std::string &name, PredicateBatchFunc batch)
+        {
+            _predicates[name] = { nullptr, batch };
+        }
+
+        void CallbackRegistry::add(const std::string &name, BindFunc bind)
+        {
+            _binds[name] = bind;
+        }
+
+        bool CallbackRegistry::predicate(const std::string &name, PredicateFunc &func, PredicateBatchFunc &batch) const
+        {
+            const auto it = _predicates.find(name);
+
+            if (it == _predicates.end())
+                return false;
+
+            func = (*it).second.func;
+            batch = (*it).second.batch;
+            return true;
+        }
+
+        bool CallbackRegistry::bind(const std::string &name, BindFunc &bind) const
+        {
+            const auto it = _binds.find(name);
+
+            if (it == _binds.end())
+                return false;
+
+            bind = (*it).second;
+            return true;
+        }
+
+        const std::string *CallbackRegistry::name(const CompiledPredicate &predicate) const
+        {
+            // Prefer entry named as predicate, function may be shared
+            const auto it = _predicates.find(predicate.name);
+
+            if (it != _predicates.end() && (*it).second.func == predicate.func && (*it).second.batch == predicate.batch)
+                return &(*it).first;
+
+            for (const auto &entry : _predicates) {
+                if (entry.second.func == predicate.func && entry.second.batch == predicate.batch)
+                    return &entry.first;
+            }
+
+            return nullptr;
+        }
+
+        const std::string *CallbackRegistry::name(BindFunc bind) const
+        {
+            for (const auto &entry : _binds) {
+                if (entry.second == bind)
+                    return &entry.first;
+            }
+
+            return nullptr;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "compileddomain.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Predicate and bind functions by name, so domains loaded
+        // from files can refer to code. Predicate name holds either
+        // single or batch function, adding one replaces the other
+        class CallbackRegistry
+        {
+        public:
+            void add(const std::string &name, PredicateFunc func);
+            void add(const std::string &name, PredicateBatchFunc batch);
+            void add(const std::string &name, BindFunc bind);
+
+            // Returns false if name is unknown
+            bool predicate(const std::string &name, PredicateFunc &func, PredicateBatchFunc &batch) const;
+            bool bind(const std::string &name, BindFunc &bind) const;
+
+            // Reverse lookups used when domain is written,
+            // null when function is not registered
+            const std::string *name(const CompiledPredicate &predicate) const;
+            const std::string *name(BindFunc bind) const;
+
+        private:
+            struct PredicateEntry
+            {
+                PredicateFunc func;
+                PredicateBatchFunc batch;
+            };
+
+        private:
+            std::unordered_map<std::string, PredicateEntry> _predicates;
+            std::unordered_map<std::string, BindFunc> _binds;
+
+        };
+    }
+}
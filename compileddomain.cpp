@@ -0,0 +1,162 @@
+#include "compileddomain.h"
+#include "domain.h"
+
+#include <cmath>
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            CompiledCondition compile(const Condition &condition)
+            {
+                CompiledCondition result{
+                    static_cast<std::uint32_t>(condition.index),
+                    condition.state,
+                    static_cast<std::uint8_t>(condition.slots.size()),
+                    {}
+                };
+
+                for (std::size_t i = 0; i < condition.slots.size(); ++i)
+                    result.slots[i] = static_cast<std::uint8_t>(condition.slots[i]);
+
+                return result;
+            }
+        }
+
+        CompiledDomain::CompiledDomain(const Domain &domain) :
+            CompiledDomain(domain.actions(), domain._predicates, domain._symbols, domain.version())
+        {
+            _epoch = domain.epoch();
+        }
+
+        CompiledDomain::CompiledDomain(
+            const std::vector<Action> &actions,
+            const std::vector<Predicate> &predicates,
+            std::shared_ptr<const SymbolTable> symbols,
+            std::uint64_t version
+        ) :
+            _symbols{ std::move(symbols) },
+            _version{ version },
+            _epoch{ 0 }
+        {
+            // Names and types are copied into owned storage first,
+            // records point into it once it stops growing
+            std::vector<std::size_t> names;
+            names.reserve(predicates.size() + actions.size());
+
+            for (const auto &predicate : predicates) {
+                names.push_back(_names.size());
+                _names.append(predicate.name.c_str(), predicate.name.size() + 1);
+                _types.insert(_types.end(), predicate.types.begin(), predicate.types.end());
+            }
+
+            for (const auto &action : actions) {
+                names.push_back(_names.size());
+                _names.append(action.name.c_str(), action.name.size() + 1);
+            }
+
+            _predicates.reserve(predicates.size());
+            std::size_t types{ 0 };
+
+            for (std::size_t i = 0; i < predicates.size(); ++i) {
+                const Predicate &predicate = predicates[i];
+                _predicates.push_back({
+                    _names.data() + names[i],
+                    _types.data() + types,
+                    static_cast<std::uint8_t>(predicate.types.size()),
+                    predicate.func,
+                    predicate.batch
+                });
+                types += predicate.types.size();
+            }
+
+            _actions.reserve(actions.size());
+            _actionNames.reserve(actions.size());
+
+            for (const auto &action : actions) {
+                _actionNames.push_back(_names.data() + names[predicates.size() + _actionNames.size()]);
+                _actions.push_back({
+                    action.cost,
+                    action.bindFunc,
+                    static_cast<std::uint32_t>(_conditions.size()),
+                    static_cast<std::uint16_t>(action.preconditions.size()),
+                    static_cast<std::uint16_t>(action.effects.size()),
+                    static_cast<std::uint8_t>(action.args)
+                });
+
+                for (const auto &precondition : action.preconditions)
+                    _conditions.push_back(compile(precondition));
+
+                for (const auto &effect : action.effects)
+                    _conditions.push_back(compile(effect));
+            }
+
+            // Same order as effect index of domain, actions ascend
+            std::vector<std::vector<std::uint32_t>> achievers(_predicates.size() * 2);
+
+            for (std::size_t i = 0; i < actions.size(); ++i) {
+                for (const auto &effect : actions[i].effects) {
+                    auto &ids = achievers[effect.index * 2 + (effect.state ? 1 : 0)];
+
+                    // Action may have several effects of the same predicate
+                    if (ids.empty() || ids.back() != i)
+                        ids.push_back(static_cast<std::uint32_t>(i));
+                }
+            }
+
+            _achieverOffsets.reserve(achievers.size() + 1);
+
+            for (const auto &ids : achievers) {
+                _achieverOffsets.push_back(static_cast<std::uint32_t>(_achievers.size()));
+                _achievers.insert(_achievers.end(), ids.begin(), ids.end());
+            }
+
+            _achieverOffsets.push_back(static_cast<std::uint32_t>(_achievers.size()));
+
+            _conditionTable = _conditions.data();
+            _offsetTable = _achieverOffsets.data();
+            _achieverTable = _achievers.data();
+            summarize();
+        }
+
+        CompiledDomain::CompiledDomain(
+            std::vector<CompiledAction> actions,
+            const CompiledCondition *conditions,
+            const std::uint32_t *achieverOffsets,
+            const std::uint32_t *achievers,
+            std::vector<CompiledPredicate> predicates,
+            std::vector<const char *> actionNames,
+            std::shared_ptr<const SymbolTable> symbols,
+            std::shared_ptr<const void> storage
+        ) :
+            _actions{ std::move(actions) },
+            _storage{ std::move(storage) },
+            _conditionTable{ conditions },
+            _offsetTable{ achieverOffsets },
+            _achieverTable{ achievers },
+            _predicates{ std::move(predicates) },
+            _actionNames{ std::move(actionNames) },
+            _symbols{ std::move(symbols) },
+            _version{ 0 },
+            _epoch{ 0 }
+        {
+            summarize();
+        }
+
+        void CompiledDomain::summarize()
+        {
+            _integralCosts = true;
+            _batched = false;
+
+            for (const auto &action : _actions) {
+                if (action.cost < 0.0 || action.cost != std::floor(action.cost))
+                    _integralCosts = false;
+            }
+
+            for (const auto &predicate : _predicates)
+                _batched = _batched || predicate.batch != nullptr;
+        }
+    }
+}
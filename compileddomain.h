@@ -0,0 +1,183 @@
+#pragma once
+
+#include "predicate.h"
+#include "action.h"
+#include "symboltable.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ai
+{
+    namespace goap
+    {
+        class Domain;
+        class DomainImage;
+
+        struct CompiledCondition
+        {
+            std::uint32_t predicate;
+            bool state;
+            std::uint8_t arity;
+            // Indices of action arguments
+            std::uint8_t slots[PredicateBind::Arity];
+        };
+
+        struct CompiledAction
+        {
+            double cost;
+            BindFunc bindFunc;
+            // Preconditions start at offset, effects follow them
+            std::uint32_t conditions;
+            std::uint16_t preconditions;
+            std::uint16_t effects;
+            std::uint8_t args;
+        };
+
+        // Name and types point into storage of snapshot. Either
+        // function is set, batch one is called with single bind
+        // when there is no other
+        struct CompiledPredicate
+        {
+            const char *name;
+            const std::uint32_t *types;
+            std::uint8_t arity;
+            PredicateFunc func;
+            PredicateBatchFunc batch;
+
+            bool operator()(Agent *a, const std::vector<Value> &v, const PredicateBind &p) const
+            {
+                return func != nullptr ? func(a, v, p) : (batch(a, v, &p, 1) & 1) != 0;
+            }
+
+            std::uint64_t operator()(Agent *a, const std::vector<Value> &v, const PredicateBind *p, std::size_t count) const
+            {
+                if (batch != nullptr)
+                    return batch(a, v, p, count);
+
+                std::uint64_t result{ 0 };
+
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (func(a, v, p[i]))
+                        result |= std::uint64_t(1) << i;
+                }
+
+                return result;
+            }
+        };
+
+        struct ActionRange
+        {
+            const std::uint32_t *first;
+            const std::uint32_t *last;
+
+            const std::uint32_t *begin() const { return first; }
+            const std::uint32_t *end() const { return last; }
+        };
+
+        // Immutable snapshot of domain used by planners. All conditions
+        // share one array and effect index is flat, so expansion doesn't
+        // chase pointers. Safe to share between threads, source domain
+        // may change afterwards and is compiled again on demand
+        class CompiledDomain
+        {
+        public:
+            explicit CompiledDomain(const Domain &domain);
+            // Domain without source, see StaticDomain. Conditions
+            // of actions refer to indices of given predicates
+            CompiledDomain(
+                const std::vector<Action> &actions,
+                const std::vector<Predicate> &predicates,
+                std::shared_ptr<const SymbolTable> symbols,
+                std::uint64_t version = 0
+            );
+            // Condition and achiever tables, names and types are used
+            // in place, storage keeps them alive, see DomainImage
+            CompiledDomain(
+                std::vector<CompiledAction> actions,
+                const CompiledCondition *conditions,
+                const std::uint32_t *achieverOffsets,
+                const std::uint32_t *achievers,
+                std::vector<CompiledPredicate> predicates,
+                std::vector<const char *> actionNames,
+                std::shared_ptr<const SymbolTable> symbols,
+                std::shared_ptr<const void> storage
+            );
+            // Tables point into owned storage
+            CompiledDomain(const CompiledDomain &) = delete;
+            CompiledDomain &operator=(const CompiledDomain &) = delete;
+
+            std::size_t actionCount() const { return _actions.size(); }
+            const CompiledAction &action(const std::size_t index) const
+            {
+                return _actions[index];
+            }
+
+            const CompiledCondition *preconditions(const CompiledAction &action) const
+            {
+                return _conditionTable + action.conditions;
+            }
+
+            const CompiledCondition *effects(const CompiledAction &action) const
+            {
+                return _conditionTable + action.conditions + action.preconditions;
+            }
+
+            // Ascending indices of actions having effect of given predicate and value
+            ActionRange achievers(const std::size_t predicate, bool value) const
+            {
+                const std::size_t literal = predicate * 2 + (value ? 1 : 0);
+                return{ _achieverTable + _offsetTable[literal], _achieverTable + _offsetTable[literal + 1] };
+            }
+
+            std::size_t predicateCount() const { return _predicates.size(); }
+            const CompiledPredicate &predicate(const std::size_t index) const
+            {
+                return _predicates[index];
+            }
+
+            const char *actionName(const std::size_t index) const
+            {
+                return _actionNames[index];
+            }
+
+            const SymbolTable &symbols() const { return *_symbols; }
+
+            bool integralCosts() const { return _integralCosts; }
+            // Some predicate has batch function
+            bool batched() const { return _batched; }
+
+            // Version of source domain at time of compilation
+            std::uint64_t version() const { return _version; }
+            // Epoch of ids, see Domain::epoch
+            std::uint64_t epoch() const { return _epoch; }
+
+        private:
+            void summarize();
+
+        private:
+            friend class DomainImage;
+            std::vector<CompiledAction> _actions;
+            // Owned tables, empty when tables live in storage
+            std::vector<CompiledCondition> _conditions;
+            std::vector<std::uint32_t> _achieverOffsets;
+            std::vector<std::uint32_t> _achievers;
+            std::string _names;
+            std::vector<std::uint32_t> _types;
+            std::shared_ptr<const void> _storage;
+            const CompiledCondition *_conditionTable;
+            const std::uint32_t *_offsetTable;
+            const std::uint32_t *_achieverTable;
+            std::vector<CompiledPredicate> _predicates;
+            std::vector<const char *> _actionNames;
+            std::shared_ptr<const SymbolTable> _symbols;
+            bool _integralCosts;
+            bool _batched;
+            std::uint64_t _version;
+            std::uint64_t _epoch;
+
+        };
+    }
+}
@@ -1,17 +1,22 @@
 #include "domain.h"
 
 #include <sstream>
+#include <algorithm>
 
 namespace ai
 {
     namespace goap
     {
-        Domain::Domain()
+        Domain::Domain() :
+            _symbols{ std::make_shared<SymbolTable>() },
+            _version{ 0 },
+            _epoch{ 0 }
         {
         }
 
         bool Domain::addType(const std::string &name)
         {
+            std::lock_guard<std::mutex> lock{ _mutex };
             const auto it = _typeMap.find(name);
 
             if (it != _typeMap.end()) {
@@ -23,16 +28,56 @@ namespace ai
 
             _typeMap.insert({ name, _types.size() });
             _types.push_back({ name });
+            publish();
 
             return true;
         }
 
         bool Domain::addPredicate(
             const std::string &name,
-            std::initializer_list<std::string> typeNames,
+            std::initializer_list<std::string> types,
             PredicateFunc func
         )
         {
+            return insertPredicate(name, types, func, nullptr);
+        }
+
+        bool Domain::addPredicate(
+            const std::string &name,
+            const std::vector<std::string> &types,
+            PredicateFunc func
+        )
+        {
+            return insertPredicate(name, types, func, nullptr);
+        }
+
+        bool Domain::addPredicate(
+            const std::string &name,
+            std::initializer_list<std::string> types,
+            PredicateBatchFunc batch
+        )
+        {
+            return insertPredicate(name, types, nullptr, batch);
+        }
+
+        bool Domain::addPredicate(
+            const std::string &name,
+            const std::vector<std::string> &types,
+            PredicateBatchFunc batch
+        )
+        {
+            return insertPredicate(name, types, nullptr, batch);
+        }
+
+        template<typename Types>
+        bool Domain::insertPredicate(
+            const std::string &name,
+            const Types &typeNames,
+            PredicateFunc func,
+            PredicateBatchFunc batch
+        )
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
             const auto it = _predicateMap.find(name);
 
             if (it != _predicateMap.end()) {
@@ -42,6 +87,14 @@ namespace ai
                 return false;
             }
 
+            // Predicate id and values have to fit bind
+            if (_predicates.size() >= PredicateBind::MaxIds || typeNames.size() > PredicateBind::Arity) {
+                std::stringstream message;
+                message << "Predicate " << name << " exceeds " << PredicateBind::MaxIds << " predicates or " << PredicateBind::Arity << " arguments";
+                _error = message.str();
+                return false;
+            }
+
             std::vector<std::size_t> types;
             types.reserve(typeNames.size());
 
@@ -59,7 +112,8 @@ namespace ai
             }
 
             _predicateMap.insert({ name, _predicates.size() });
-            _predicates.push_back({ name, std::move(types), func });
+            _predicates.push_back({ name, std::move(types), func, batch });
+            publish();
 
             return true;
         }
@@ -73,6 +127,32 @@ namespace ai
             BindFunc bindFunc
         )
         {
+            return insertAction(name, cost, args, preconditions, effects, bindFunc);
+        }
+
+        bool Domain::addAction(
+            const std::string &name,
+            double cost,
+            const std::vector<ArgDesc> &args,
+            const std::vector<ConditionDesc> &preconditions,
+            const std::vector<ConditionDesc> &effects,
+            BindFunc bindFunc
+        )
+        {
+            return insertAction(name, cost, args, preconditions, effects, bindFunc);
+        }
+
+        template<typename Args, typename Conditions>
+        bool Domain::insertAction(
+            const std::string &name,
+            double cost,
+            const Args &args,
+            const Conditions &preconditions,
+            const Conditions &effects,
+            BindFunc bindFunc
+        )
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
             const auto it = _actionMap.find(name);
 
             if (it != _actionMap.end()) {
@@ -82,6 +162,13 @@ namespace ai
                 return false;
             }
 
+            if (_actions.size() >= ActionBind::MaxIds || args.size() > ActionBind::Arity) {
+                std::stringstream message;
+                message << "Action " << name << " exceeds " << ActionBind::MaxIds << " actions or " << ActionBind::Arity << " arguments";
+                _error = message.str();
+                return false;
+            }
+
             std::unordered_map<std::string, std::size_t> argMap;
             std::size_t index{ 0 };
 
@@ -110,6 +197,13 @@ namespace ai
                     return false;
                 }
 
+                if (condition.args.size() != _predicates[(*it).second].types.size()) {
+                    std::stringstream message;
+                    message << "Predicate " << condition.name << " expects " << _predicates[(*it).second].types.size() << " arguments";
+                    _error = message.str();
+                    return false;
+                }
+
                 std::vector<std::size_t> args;
 
                 for (const auto &arg : condition.args) {
@@ -140,6 +234,13 @@ namespace ai
                     return false;
                 }
 
+                if (condition.args.size() != _predicates[(*it).second].types.size()) {
+                    std::stringstream message;
+                    message << "Predicate " << condition.name << " expects " << _predicates[(*it).second].types.size() << " arguments";
+                    _error = message.str();
+                    return false;
+                }
+
                 std::vector<std::size_t> args;
 
                 for (const auto &arg : condition.args) {
@@ -160,19 +261,196 @@ namespace ai
 
             _actionMap.insert({ name, _actions.size() });
             _actions.push_back({ name, cost, args.size(), std::move(pre), std::move(post), bindFunc });
+            publish();
+
+            return true;
+        }
+
+        bool Domain::removeAction(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            const auto it = _actionMap.find(name);
+
+            if (it == _actionMap.end()) {
+                std::stringstream message;
+                message << "Domain doesn't contains " << name << " action";
+                _error = message.str();
+                return false;
+            }
+
+            const std::size_t removed{ (*it).second };
+            _actions.erase(_actions.begin() + removed);
+            _actionMap.erase(it);
+
+            for (auto &entry : _actionMap) {
+                if (entry.second > removed)
+                    --entry.second;
+            }
+
+            ++_epoch;
+            publish();
 
             return true;
         }
 
+        bool Domain::removeType(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            const auto it = _typeMap.find(name);
+
+            if (it == _typeMap.end()) {
+                std::stringstream message;
+                message << "Domain doesn't contains " << name << " type";
+                _error = message.str();
+                return false;
+            }
+
+            const std::size_t removed{ (*it).second };
+
+            for (const auto &predicate : _predicates) {
+                for (const auto type : predicate.types) {
+                    if (type == removed) {
+                        std::stringstream message;
+                        message << "Type " << name << " is used by " << predicate.name << " predicate";
+                        _error = message.str();
+                        return false;
+                    }
+                }
+            }
+
+            _types.erase(_types.begin() + removed);
+            _typeMap.erase(it);
+
+            for (auto &entry : _typeMap) {
+                if (entry.second > removed)
+                    --entry.second;
+            }
+
+            for (auto &predicate : _predicates) {
+                for (auto &type : predicate.types) {
+                    if (type > removed)
+                        --type;
+                }
+            }
+
+            ++_epoch;
+            publish();
+
+            return true;
+        }
+
+        bool Domain::removePredicate(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            const auto it = _predicateMap.find(name);
+
+            if (it == _predicateMap.end()) {
+                std::stringstream message;
+                message << "Domain doesn't contains " << name << " predicate";
+                _error = message.str();
+                return false;
+            }
+
+            const std::size_t removed{ (*it).second };
+
+            for (const auto &action : _actions) {
+                for (const auto *conditions : { &action.preconditions, &action.effects }) {
+                    for (const auto &condition : *conditions) {
+                        if (condition.index == removed) {
+                            std::stringstream message;
+                            message << "Predicate " << name << " is used by " << action.name << " action";
+                            _error = message.str();
+                            return false;
+                        }
+                    }
+                }
+            }
+
+            _predicates.erase(_predicates.begin() + removed);
+            _predicateMap.erase(it);
+
+            for (auto &entry : _predicateMap) {
+                if (entry.second > removed)
+                    --entry.second;
+            }
+
+            for (auto &action : _actions) {
+                for (auto *conditions : { &action.preconditions, &action.effects }) {
+                    for (auto &condition : *conditions) {
+                        if (condition.index > removed)
+                            --condition.index;
+                    }
+                }
+            }
+
+            ++_epoch;
+            publish();
+
+            return true;
+        }
+
+        std::shared_ptr<const CompiledDomain> Domain::compile() const
+        {
+            std::shared_ptr<const CompiledDomain> compiled = std::atomic_load(&_compiled);
+
+            if (compiled != nullptr)
+                return compiled;
+
+            // Domain is compiled once, every change publishes after that
+            std::lock_guard<std::mutex> lock{ _mutex };
+            compiled = std::atomic_load(&_compiled);
+
+            if (compiled == nullptr) {
+                compiled = std::make_shared<const CompiledDomain>(*this);
+                std::atomic_store(&_compiled, compiled);
+            }
+
+            return compiled;
+        }
+
+        void Domain::publish()
+        {
+            ++_version;
+
+            // Planners holding previous snapshot finish with it,
+            // it is released together with their last reference
+            if (std::atomic_load(&_compiled) != nullptr)
+                std::atomic_store(&_compiled, std::make_shared<const CompiledDomain>(*this));
+        }
+
         Goal Domain::goal(
             std::initializer_list<ValueDesc> values,
             std::initializer_list<ConditionDesc> conditions
         )
         {
-            std::unordered_map<std::string, std::size_t> valueMap;
+            return makeGoal(values, conditions);
+        }
+
+        Goal Domain::goal(
+            const std::vector<ValueDesc> &values,
+            const std::vector<ConditionDesc> &conditions
+        )
+        {
+            return makeGoal(values, conditions);
+        }
+
+        template<typename Values, typename Conditions>
+        Goal Domain::makeGoal(
+            const Values &values,
+            const Conditions &conditions
+        )
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
             std::vector<Value> out;
             out.reserve(values.size());
 
+            if (values.size() > PredicateBind::MaxValues) {
+                std::stringstream message;
+                message << "Goal exceeds " << PredicateBind::MaxValues << " values";
+                _error = message.str();
+                return{};
+            }
+
             for (const auto &value : values) {
                 const auto it = _typeMap.find(value.type);
 
@@ -183,8 +461,14 @@ namespace ai
                     return{};
                 }
 
-                valueMap.insert({ value.name, out.size() });
-                out.push_back({ (*it).second, value.value });
+                const Literal &literal = value.value;
+                Value result{ static_cast<std::uint32_t>((*it).second), literal.kind, literal.data };
+
+                // Literal made from symbol id has no name
+                if (literal.kind == ValueKind::Symbol && literal.name.data() != nullptr)
+                    result.data = (*_symbols).intern(literal.name).id;
+
+                out.push_back(result);
             }
 
             std::vector<Condition> cond;
@@ -199,25 +483,77 @@ namespace ai
                     return{};
                 }
 
+                if (condition.args.size() != _predicates[(*it).second].types.size()) {
+                    std::stringstream message;
+                    message << "Predicate " << condition.name << " expects " << _predicates[(*it).second].types.size() << " arguments";
+                    _error = message.str();
+                    return{};
+                }
+
                 std::vector<std::size_t> args;
 
                 for (const auto &arg : condition.args) {
-                    const auto it = valueMap.find(arg);
+                    // Goals have few values, so names are matched in place
+                    const auto it = std::find_if(values.begin(), values.end(), [&arg](const ValueDesc &value) {
+                        return value.name == arg;
+                    });
 
-                    if (it == valueMap.end()) {
+                    if (it == values.end()) {
                         std::stringstream message;
                         message << "Argument " << arg << " not found in goal values";
                         _error = message.str();
                         return{};
                     }
 
-                    args.push_back((*it).second);
+                    args.push_back(it - values.begin());
                 }
 
                 cond.push_back({ (*it).second, args, condition.state });
             }
 
-            return{ out, cond };
+            return{ out, cond, _epoch };
+        }
+
+        GoalTemplate Domain::goalTemplate(
+            std::initializer_list<ArgDesc> parameters,
+            std::initializer_list<ValueDesc> values,
+            std::initializer_list<ConditionDesc> conditions
+        )
+        {
+            return makeTemplate(parameters, values, conditions);
+        }
+
+        GoalTemplate Domain::goalTemplate(
+            const std::vector<ArgDesc> &parameters,
+            const std::vector<ValueDesc> &values,
+            const std::vector<ConditionDesc> &conditions
+        )
+        {
+            return makeTemplate(parameters, values, conditions);
+        }
+
+        template<typename Parameters, typename Values, typename Conditions>
+        GoalTemplate Domain::makeTemplate(
+            const Parameters &parameters,
+            const Values &values,
+            const Conditions &conditions
+        )
+        {
+            std::vector<ValueDesc> all;
+            all.reserve(parameters.size() + values.size());
+
+            // Payload of parameter is given on instantiation
+            for (const auto &parameter : parameters)
+                all.push_back({ parameter.name, parameter.type, Literal{ std::int64_t(0) } });
+
+            all.insert(all.end(), values.begin(), values.end());
+
+            Goal goal = makeGoal(all, conditions);
+
+            if (goal.values.size() != all.size() || goal.conditions.size() != conditions.size())
+                return{};
+
+            return{ std::move(goal), parameters.size() };
         }
     }
 }
\ No newline at end of file
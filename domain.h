@@ -4,16 +4,24 @@
 #include "predicate.h"
 #include "action.h"
 #include "goal.h"
+#include "goaltemplate.h"
+#include "compileddomain.h"
+#include "symboltable.h"
 
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 namespace ai
 {
     namespace goap
     {
-        // TODO: load from yaml file
+        // Descriptions of domain entries by name, domains may
+        // also be loaded from text, see DomainLoader
         struct ArgDesc
         {
             std::string name;
@@ -31,20 +39,44 @@ namespace ai
         {
             std::string name;
             std::string type;
-            std::string value;
+            Literal value;
         };        
 
+        // Source of planning domain. Changes are serialized, each one
+        // publishes new immutable snapshot once domain has been compiled,
+        // so planners keep consistent view during plan and pick latest
+        // version up on next plan without waiting for writers
         class Domain
         {
         public:
             Domain();
 
             bool addType(const std::string &name);
+            // Fails while some predicate has argument of this type
+            bool removeType(const std::string &name);
             bool addPredicate(
                 const std::string &name,
                 std::initializer_list<std::string> types,
                 PredicateFunc func
             );
+            // Vector overloads serve domains built at runtime
+            bool addPredicate(
+                const std::string &name,
+                const std::vector<std::string> &types,
+                PredicateFunc func
+            );
+            // Planner gathers unknown facts of all successors
+            // of expanded state and evaluates them in batches
+            bool addPredicate(
+                const std::string &name,
+                std::initializer_list<std::string> types,
+                PredicateBatchFunc batch
+            );
+            bool addPredicate(
+                const std::string &name,
+                const std::vector<std::string> &types,
+                PredicateBatchFunc batch
+            );
             bool addAction(
                 const std::string &name,
                 double cost,
@@ -53,17 +85,68 @@ namespace ai
                 std::initializer_list<ConditionDesc> effects,
                 BindFunc bindFunc = nullptr
             );
+            bool addAction(
+                const std::string &name,
+                double cost,
+                const std::vector<ArgDesc> &args,
+                const std::vector<ConditionDesc> &preconditions,
+                const std::vector<ConditionDesc> &effects,
+                BindFunc bindFunc = nullptr
+            );
+            // Fails while some action uses predicate
+            bool removePredicate(const std::string &name);
+            // Actions after removed one are shifted down
+            bool removeAction(const std::string &name);
+
+            // Bumped by removals, which shift ids of later types, predicates
+            // or actions. Goals and plans of older epoch refer to other
+            // ids, planners reject such goals and predicate caches drop
+            // results of older epoch
+            std::uint64_t epoch() const { return _epoch; }
 
+            // Symbols may be interned upfront, so goals
+            // and bind functions don't look names up
+            Symbol intern(std::string_view name) { return (*_symbols).intern(name); }
+            const SymbolTable &symbols() const { return *_symbols; }
+
+            Goal goal(
+                std::initializer_list<ValueDesc> values,
+                std::initializer_list<ConditionDesc> conditions
+            );
             Goal goal(
+                const std::vector<ValueDesc> &values,
+                const std::vector<ConditionDesc> &conditions
+            );
+            // Parameters come first in values of goal, conditions refer
+            // to them by name. Template made once is instantiated for
+            // every replan, failed one isn't valid and reason is in error
+            GoalTemplate goalTemplate(
+                std::initializer_list<ArgDesc> parameters,
                 std::initializer_list<ValueDesc> values,
                 std::initializer_list<ConditionDesc> conditions
             );
+            GoalTemplate goalTemplate(
+                const std::vector<ArgDesc> &parameters,
+                const std::vector<ValueDesc> &values,
+                const std::vector<ConditionDesc> &conditions
+            );
+
+            // Accessors below are not synchronized with changes,
+            // concurrent readers should use compiled snapshot
+            const Type &type(const std::size_t index) const
+            {
+                return _types[index];
+            }
+
+            std::size_t typeCount() const { return _types.size(); }
 
             const Predicate &predicate(const std::size_t index) const
             {
                 return _predicates[index];
             }
 
+            std::size_t predicateCount() const { return _predicates.size(); }
+
             const std::vector<Action> &actions() const{ return _actions; }
 
             const Action &action(const std::size_t index) const
@@ -71,8 +154,38 @@ namespace ai
                 return _actions[index];
             }
 
+            // Reason of last failed change
+            const std::string &error() const { return _error; }
+
+            // Bumped on every change, so derived data can tell it is stale
+            std::uint64_t version() const { return _version; }
+
+            // Latest published snapshot, lock free once domain was compiled.
+            // Snapshot lives while any planner holds it
+            std::shared_ptr<const CompiledDomain> compile() const;
+
+        private:
+            template<typename Types>
+            bool insertPredicate(const std::string &name, const Types &typeNames, PredicateFunc func, PredicateBatchFunc batch);
+            template<typename Args, typename Conditions>
+            bool insertAction(
+                const std::string &name,
+                double cost,
+                const Args &args,
+                const Conditions &preconditions,
+                const Conditions &effects,
+                BindFunc bindFunc
+            );
+            template<typename Values, typename Conditions>
+            Goal makeGoal(const Values &values, const Conditions &conditions);
+            template<typename Parameters, typename Values, typename Conditions>
+            GoalTemplate makeTemplate(const Parameters &parameters, const Values &values, const Conditions &conditions);
+
+            void publish();
+
         private:
             friend class Planner;
+            friend class CompiledDomain;
             std::string _error;
             std::vector<Type> _types;
             std::unordered_map<std::string, std::size_t> _typeMap;
@@ -80,6 +193,14 @@ namespace ai
             std::unordered_map<std::string, std::size_t> _predicateMap;
             std::vector<Action> _actions;
             std::unordered_map<std::string, std::size_t> _actionMap;
+            // Shared with snapshots, which may outlive domain
+            std::shared_ptr<SymbolTable> _symbols;
+            std::atomic<std::uint64_t> _version;
+            std::atomic<std::uint64_t> _epoch;
+            // Serializes changes with each other and with first compilation
+            mutable std::mutex _mutex;
+            // Only accessed with atomic shared_ptr functions
+            mutable std::shared_ptr<const CompiledDomain> _compiled;
 
         };
     }
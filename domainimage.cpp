@@ -0,0 +1,584 @@
+#include "domainimage.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            const char Magic[8]{ 'G', 'O', 'A', 'P', 'D', 'O', 'M', '1' };
+            const std::uint32_t ByteOrder{ 0x01020304 };
+            const std::uint32_t Layout{ GOAP_PREDICATE_BITS | GOAP_ACTION_BITS << 8 | GOAP_VALUE_BITS << 16 };
+            const std::uint32_t NoName{ std::uint32_t(-1) };
+
+            // Sections follow header in this order, each one aligned to
+            // eight bytes. Strings are zero terminated and referred to
+            // by offset into string section
+            struct Header
+            {
+                char magic[8];
+                std::uint32_t layout;
+                std::uint32_t order;
+                std::uint32_t typeCount;
+                std::uint32_t predicateCount;
+                std::uint32_t actionCount;
+                std::uint32_t conditionCount;
+                std::uint32_t achieverCount;
+                std::uint32_t stringSize;
+                std::uint64_t types;
+                std::uint64_t predicates;
+                std::uint64_t actions;
+                std::uint64_t conditions;
+                // Achiever offsets per predicate literal, plus end
+                std::uint64_t literals;
+                std::uint64_t achievers;
+                std::uint64_t strings;
+                std::uint64_t size;
+            };
+
+            struct ImagePredicate
+            {
+                std::uint32_t name;
+                std::uint32_t callback;
+                std::uint32_t arity;
+                std::uint32_t types[PredicateBind::Arity];
+            };
+
+            struct ImageAction
+            {
+                double cost;
+                std::uint32_t name;
+                std::uint32_t bind;
+                std::uint32_t conditions;
+                std::uint16_t preconditions;
+                std::uint16_t effects;
+                std::uint32_t args;
+                std::uint32_t reserved;
+            };
+
+            static_assert(std::is_trivially_copyable<CompiledCondition>::value, "Conditions are mapped as they are");
+
+            std::uint64_t align(std::uint64_t offset)
+            {
+                return (offset + 7) & ~std::uint64_t(7);
+            }
+
+            // Section of count items lies within image
+            bool fits(std::uint64_t offset, std::uint64_t count, std::uint64_t item, std::uint64_t size)
+            {
+                return offset % 8 == 0 && offset <= size && count <= (size - offset) / item;
+            }
+        }
+
+        // Read only view of whole file
+        struct DomainImage::Mapping
+        {
+            const char *data = nullptr;
+            std::size_t size = 0;
+#if defined(_WIN32)
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+#endif
+
+            Mapping() = default;
+            Mapping(const Mapping &) = delete;
+            Mapping &operator=(const Mapping &) = delete;
+
+            ~Mapping()
+            {
+#if defined(_WIN32)
+                if (data != nullptr)
+                    UnmapViewOfFile(data);
+
+                if (mapping != nullptr)
+                    CloseHandle(mapping);
+
+                if (file != INVALID_HANDLE_VALUE)
+                    CloseHandle(file);
+#else
+                if (data != nullptr)
+                    munmap(const_cast<char *>(data), size);
+#endif
+            }
+
+            bool map(const std::string &path)
+            {
+#if defined(_WIN32)
+                file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+                if (file == INVALID_HANDLE_VALUE)
+                    return false;
+
+                LARGE_INTEGER length;
+
+                if (!GetFileSizeEx(file, &length) || length.QuadPart == 0)
+                    return false;
+
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+                if (mapping == nullptr)
+                    return false;
+
+                data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                size = static_cast<std::size_t>(length.QuadPart);
+                return data != nullptr;
+#else
+                const int file = ::open(path.c_str(), O_RDONLY);
+
+                if (file < 0)
+                    return false;
+
+                struct stat status;
+
+                if (fstat(file, &status) != 0 || status.st_size == 0) {
+                    ::close(file);
+                    return false;
+                }
+
+                void *view = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+                ::close(file);
+
+                if (view == MAP_FAILED)
+                    return false;
+
+                data = static_cast<const char *>(view);
+                size = static_cast<std::size_t>(status.st_size);
+                return true;
+#endif
+            }
+        };
+
+        DomainImage::DomainImage(const CallbackRegistry &registry) :
+            _registry{ registry },
+            _symbols{ std::make_shared<SymbolTable>() },
+            _strings{ nullptr },
+            _typeNames{ nullptr },
+            _typeCount{ 0 }
+        {
+        }
+
+        bool DomainImage::write(const Domain &domain, std::ostream &stream)
+        {
+            const std::shared_ptr<const CompiledDomain> compiled = domain.compile();
+            const CompiledDomain &source = *compiled;
+            std::string strings;
+
+            const auto intern = [&strings](const std::string &name) {
+                const std::uint32_t offset{ static_cast<std::uint32_t>(strings.size()) };
+                strings.append(name.c_str(), name.size() + 1);
+                return offset;
+            };
+
+            std::vector<std::uint32_t> types;
+
+            for (std::size_t i = 0; i < domain.typeCount(); ++i)
+                types.push_back(intern(domain.type(i).name));
+
+            std::vector<ImagePredicate> predicates;
+
+            for (std::size_t i = 0; i < source.predicateCount(); ++i) {
+                const CompiledPredicate &predicate = source.predicate(i);
+                const std::string *callback = _registry.name(predicate);
+
+                if (callback == nullptr)
+                    return fail(std::string{ "Predicate " } + predicate.name + " has unregistered function");
+
+                ImagePredicate record{ intern(predicate.name), intern(*callback), predicate.arity, {} };
+
+                for (std::size_t t = 0; t < predicate.arity; ++t)
+                    record.types[t] = predicate.types[t];
+
+                predicates.push_back(record);
+            }
+
+            std::vector<ImageAction> actions;
+
+            for (std::size_t i = 0; i < source.actionCount(); ++i) {
+                const CompiledAction &action = source.action(i);
+                std::uint32_t bind{ NoName };
+
+                if (action.bindFunc != nullptr) {
+                    const std::string *name = _registry.name(action.bindFunc);
+
+                    if (name == nullptr)
+                        return fail(std::string{ "Action " } + source.actionName(i) + " has unregistered bind function");
+
+                    bind = intern(*name);
+                }
+
+                actions.push_back({
+                    action.cost,
+                    intern(source.actionName(i)),
+                    bind,
+                    action.conditions,
+                    action.preconditions,
+                    action.effects,
+                    action.args,
+                    0
+                });
+            }
+
+            Header header{};
+            std::memcpy(header.magic, Magic, sizeof(Magic));
+            header.layout = Layout;
+            header.order = ByteOrder;
+            header.typeCount = static_cast<std::uint32_t>(types.size());
+            header.predicateCount = static_cast<std::uint32_t>(predicates.size());
+            header.actionCount = static_cast<std::uint32_t>(actions.size());
+            header.conditionCount = static_cast<std::uint32_t>(source._conditions.size());
+            header.achieverCount = static_cast<std::uint32_t>(source._achievers.size());
+            header.stringSize = static_cast<std::uint32_t>(strings.size());
+
+            header.types = align(sizeof(Header));
+            header.predicates = align(header.types + types.size() * sizeof(std::uint32_t));
+            header.actions = align(header.predicates + predicates.size() * sizeof(ImagePredicate));
+            header.conditions = align(header.actions + actions.size() * sizeof(ImageAction));
+            header.literals = align(header.conditions + source._conditions.size() * sizeof(CompiledCondition));
+            header.achievers = align(header.literals + source._achieverOffsets.size() * sizeof(std::uint32_t));
+            header.strings = align(header.achievers + source._achievers.size() * sizeof(std::uint32_t));
+            header.size = align(header.strings + strings.size());
+
+            std::vector<char> image(static_cast<std::size_t>(header.size), 0);
+
+            const auto place = [&image](std::uint64_t offset, const void *data, std::size_t bytes) {
+                if (bytes != 0)
+                    std::memcpy(image.data() + offset, data, bytes);
+            };
+
+            place(0, &header, sizeof(header));
+            place(header.types, types.data(), types.size() * sizeof(std::uint32_t));
+            place(header.predicates, predicates.data(), predicates.size() * sizeof(ImagePredicate));
+            place(header.actions, actions.data(), actions.size() * sizeof(ImageAction));
+            place(header.conditions, source._conditions.data(), source._conditions.size() * sizeof(CompiledCondition));
+            place(header.literals, source._achieverOffsets.data(), source._achieverOffsets.size() * sizeof(std::uint32_t));
+            place(header.achievers, source._achievers.data(), source._achievers.size() * sizeof(std::uint32_t));
+            place(header.strings, strings.data(), strings.size());
+
+            if (!stream.write(image.data(), image.size()))
+                return fail("Can't write image");
+
+            return true;
+        }
+
+        bool DomainImage::writeFile(const Domain &domain, const std::string &path)
+        {
+            std::ofstream file{ path, std::ios::binary };
+
+            if (!file)
+                return fail("Can't open " + path);
+
+            return write(domain, file);
+        }
+
+        bool DomainImage::open(const std::string &path)
+        {
+            auto mapping = std::make_shared<Mapping>();
+
+            if (!(*mapping).map(path))
+                return fail("Can't map " + path);
+
+            const char *data = (*mapping).data;
+            const std::uint64_t size = (*mapping).size;
+
+            if (size < sizeof(Header))
+                return fail(path + " is not domain image");
+
+            const Header &header = *reinterpret_cast<const Header *>(data);
+
+            if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+                return fail(path + " is not domain image");
+
+            if (header.layout != Layout || header.order != ByteOrder)
+                return fail(path + " was written with other bind layout or byte order");
+
+            const std::size_t literalCount{ std::size_t(header.predicateCount) * 2 + 1 };
+
+            if (header.size != size ||
+                !fits(header.types, header.typeCount, sizeof(std::uint32_t), size) ||
+                !fits(header.predicates, header.predicateCount, sizeof(ImagePredicate), size) ||
+                !fits(header.actions, header.actionCount, sizeof(ImageAction), size) ||
+                !fits(header.conditions, header.conditionCount, sizeof(CompiledCondition), size) ||
+                !fits(header.literals, literalCount, sizeof(std::uint32_t), size) ||
+                !fits(header.achievers, header.achieverCount, sizeof(std::uint32_t), size) ||
+                !fits(header.strings, header.stringSize, 1, size) ||
+                (header.stringSize != 0 && data[header.strings + header.stringSize - 1] != '\0'))
+                return fail(path + " is truncated");
+
+            if (header.predicateCount > PredicateBind::MaxIds || header.actionCount > ActionBind::MaxIds)
+                return fail(path + " exceeds ids of bind layout");
+
+            const char *strings = data + header.strings;
+            const auto *types = reinterpret_cast<const std::uint32_t *>(data + header.types);
+            const auto *imagePredicates = reinterpret_cast<const ImagePredicate *>(data + header.predicates);
+            const auto *imageActions = reinterpret_cast<const ImageAction *>(data + header.actions);
+            const auto *conditions = reinterpret_cast<const CompiledCondition *>(data + header.conditions);
+            const auto *literals = reinterpret_cast<const std::uint32_t *>(data + header.literals);
+            const auto *achievers = reinterpret_cast<const std::uint32_t *>(data + header.achievers);
+
+            // Planner trusts tables, so every index is checked once here
+            const auto named = [&header](std::uint32_t name) { return name < header.stringSize; };
+
+            for (std::size_t i = 0; i < header.typeCount; ++i) {
+                if (!named(types[i]))
+                    return fail(path + " has invalid type");
+            }
+
+            for (std::size_t i = 0; i < header.predicateCount; ++i) {
+                const ImagePredicate &predicate = imagePredicates[i];
+                bool valid{ named(predicate.name) && named(predicate.callback) && predicate.arity <= PredicateBind::Arity };
+
+                for (std::size_t t = 0; valid && t < predicate.arity; ++t)
+                    valid = predicate.types[t] < header.typeCount;
+
+                if (!valid)
+                    return fail(path + " has invalid predicate");
+            }
+
+            for (std::size_t i = 0; i < header.actionCount; ++i) {
+                const ImageAction &action = imageActions[i];
+                const std::uint64_t end{ std::uint64_t(action.conditions) + action.preconditions + action.effects };
+                bool valid{ named(action.name) && (action.bind == NoName || named(action.bind)) &&
+                    action.cost >= 0.0 && action.args <= ActionBind::Arity && end <= header.conditionCount };
+
+                for (std::uint64_t c = action.conditions; valid && c < end; ++c) {
+                    const CompiledCondition &condition = conditions[c];
+                    unsigned char state;
+                    std::memcpy(&state, &condition.state, 1);
+
+                    valid = state <= 1 && condition.predicate < header.predicateCount &&
+                        condition.arity == imagePredicates[condition.predicate].arity;
+
+                    for (std::size_t s = 0; valid && s < condition.arity; ++s)
+                        valid = condition.slots[s] < action.args;
+                }
+
+                if (!valid)
+                    return fail(path + " has invalid action");
+            }
+
+            for (std::size_t i = 0; i < literalCount; ++i) {
+                if (literals[i] > header.achieverCount || (i != 0 && literals[i] < literals[i - 1]))
+                    return fail(path + " has invalid achievers");
+            }
+
+            for (std::size_t i = 0; i < header.achieverCount; ++i) {
+                if (achievers[i] >= header.actionCount)
+                    return fail(path + " has invalid achievers");
+            }
+
+            // Names and types stay in mapping, only callbacks are resolved
+            std::vector<CompiledPredicate> predicates;
+            predicates.reserve(header.predicateCount);
+
+            for (std::size_t i = 0; i < header.predicateCount; ++i) {
+                const ImagePredicate &predicate = imagePredicates[i];
+                PredicateFunc func;
+                PredicateBatchFunc batch;
+
+                if (!_registry.predicate(strings + predicate.callback, func, batch))
+                    return fail(std::string{ "Registry doesn't contain " } + (strings + predicate.callback) + " predicate");
+
+                predicates.push_back({ strings + predicate.name, predicate.types, static_cast<std::uint8_t>(predicate.arity), func, batch });
+            }
+
+            std::vector<CompiledAction> actions;
+            std::vector<const char *> names;
+            actions.reserve(header.actionCount);
+            names.reserve(header.actionCount);
+
+            for (std::size_t i = 0; i < header.actionCount; ++i) {
+                const ImageAction &action = imageActions[i];
+                BindFunc bind{ nullptr };
+
+                if (action.bind != NoName && !_registry.bind(strings + action.bind, bind))
+                    return fail(std::string{ "Registry doesn't contain " } + (strings + action.bind) + " bind function");
+
+                actions.push_back({ action.cost, bind, action.conditions, action.preconditions, action.effects, static_cast<std::uint8_t>(action.args) });
+                names.push_back(strings + action.name);
+            }
+
+            _domain = std::make_shared<const CompiledDomain>(
+                std::move(actions),
+                conditions,
+                literals,
+                achievers,
+                std::move(predicates),
+                std::move(names),
+                _symbols,
+                std::move(mapping)
+            );
+            _strings = strings;
+            _typeNames = types;
+            _typeCount = header.typeCount;
+
+            return true;
+        }
+
+        Goal DomainImage::goal(
+            std::initializer_list<ValueDesc> values,
+            std::initializer_list<ConditionDesc> conditions
+        )
+        {
+            return makeGoal(values, conditions);
+        }
+
+        Goal DomainImage::goal(
+            const std::vector<ValueDesc> &values,
+            const std::vector<ConditionDesc> &conditions
+        )
+        {
+            return makeGoal(values, conditions);
+        }
+
+        template<typename Values, typename Conditions>
+        Goal DomainImage::makeGoal(
+            const Values &values,
+            const Conditions &conditions
+        )
+        {
+            if (_domain == nullptr) {
+                fail("Image is not open");
+                return{};
+            }
+
+            if (values.size() > PredicateBind::MaxValues) {
+                std::stringstream message;
+                message << "Goal exceeds " << PredicateBind::MaxValues << " values";
+                fail(message.str());
+                return{};
+            }
+
+            const CompiledDomain &domain = *_domain;
+            std::vector<Value> out;
+            out.reserve(values.size());
+
+            // Images have no name maps, goals are made rarely
+            // and match names in place
+            for (const auto &value : values) {
+                std::size_t type{ 0 };
+
+                while (type < _typeCount && value.type != typeName(type))
+                    ++type;
+
+                if (type == _typeCount) {
+                    fail("Image doesn't contain " + value.type + " type");
+                    return{};
+                }
+
+                const Literal &literal = value.value;
+                Value result{ static_cast<std::uint32_t>(type), literal.kind, literal.data };
+
+                // Literal made from symbol id has no name
+                if (literal.kind == ValueKind::Symbol && literal.name.data() != nullptr)
+                    result.data = (*_symbols).intern(literal.name).id;
+
+                out.push_back(result);
+            }
+
+            std::vector<Condition> cond;
+
+            for (const auto &condition : conditions) {
+                std::size_t predicate{ 0 };
+
+                while (predicate < domain.predicateCount() && condition.name != domain.predicate(predicate).name)
+                    ++predicate;
+
+                if (predicate == domain.predicateCount()) {
+                    fail("Image doesn't contain " + condition.name + " predicate");
+                    return{};
+                }
+
+                if (condition.args.size() != domain.predicate(predicate).arity) {
+                    std::stringstream message;
+                    message << "Predicate " << condition.name << " expects " << std::size_t(domain.predicate(predicate).arity) << " arguments";
+                    fail(message.str());
+                    return{};
+                }
+
+                std::vector<std::size_t> args;
+
+                for (const auto &arg : condition.args) {
+                    const auto it = std::find_if(values.begin(), values.end(), [&arg](const ValueDesc &value) {
+                        return value.name == arg;
+                    });
+
+                    if (it == values.end()) {
+                        fail("Argument " + arg + " not found in goal values");
+                        return{};
+                    }
+
+                    args.push_back(it - values.begin());
+                }
+
+                cond.push_back({ predicate, args, condition.state });
+            }
+
+            return{ out, cond };
+        }
+
+        GoalTemplate DomainImage::goalTemplate(
+            std::initializer_list<ArgDesc> parameters,
+            std::initializer_list<ValueDesc> values,
+            std::initializer_list<ConditionDesc> conditions
+        )
+        {
+            return makeTemplate(parameters, values, conditions);
+        }
+
+        GoalTemplate DomainImage::goalTemplate(
+            const std::vector<ArgDesc> &parameters,
+            const std::vector<ValueDesc> &values,
+            const std::vector<ConditionDesc> &conditions
+        )
+        {
+            return makeTemplate(parameters, values, conditions);
+        }
+
+        template<typename Parameters, typename Values, typename Conditions>
+        GoalTemplate DomainImage::makeTemplate(
+            const Parameters &parameters,
+            const Values &values,
+            const Conditions &conditions
+        )
+        {
+            std::vector<ValueDesc> all;
+            all.reserve(parameters.size() + values.size());
+
+            // Payload of parameter is given on instantiation
+            for (const auto &parameter : parameters)
+                all.push_back({ parameter.name, parameter.type, Literal{ std::int64_t(0) } });
+
+            all.insert(all.end(), values.begin(), values.end());
+
+            Goal goal = makeGoal(all, conditions);
+
+            if (goal.values.size() != all.size() || goal.conditions.size() != conditions.size())
+                return{};
+
+            return{ std::move(goal), parameters.size() };
+        }
+
+        bool DomainImage::fail(const std::string &message)
+        {
+            _error = message;
+            return false;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "domain.h"
+#include "compileddomain.h"
+#include "callbackregistry.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Read only domain compiled offline. File holds condition and
+        // achiever tables in the layout planners read, opening maps
+        // it and uses them in place, so startup doesn't parse or look
+        // names up. Names stay in mapping, only callbacks are resolved.
+        // Image is tied to bind layout and byte order of its writer
+        class DomainImage
+        {
+        public:
+            explicit DomainImage(const CallbackRegistry &registry);
+
+            // Callbacks of domain must be registered
+            bool write(const Domain &domain, std::ostream &stream);
+            bool writeFile(const Domain &domain, const std::string &path);
+
+            // Previous domain stays valid while planners hold it,
+            // symbols are kept
+            bool open(const std::string &path);
+
+            // Null until image is opened
+            const std::shared_ptr<const CompiledDomain> &domain() const { return _domain; }
+
+            // Symbols may be interned upfront, so goals
+            // and bind functions don't look names up
+            Symbol intern(std::string_view name) { return (*_symbols).intern(name); }
+
+            std::size_t typeCount() const { return _typeCount; }
+            const char *typeName(const std::size_t index) const
+            {
+                return _strings + _typeNames[index];
+            }
+
+            Goal goal(
+                std::initializer_list<ValueDesc> values,
+                std::initializer_list<ConditionDesc> conditions
+            );
+            Goal goal(
+                const std::vector<ValueDesc> &values,
+                const std::vector<ConditionDesc> &conditions
+            );
+            // See Domain::goalTemplate
+            GoalTemplate goalTemplate(
+                std::initializer_list<ArgDesc> parameters,
+                std::initializer_list<ValueDesc> values,
+                std::initializer_list<ConditionDesc> conditions
+            );
+            GoalTemplate goalTemplate(
+                const std::vector<ArgDesc> &parameters,
+                const std::vector<ValueDesc> &values,
+                const std::vector<ConditionDesc> &conditions
+            );
+
+            // Reason of last failed call
+            const std::string &error() const { return _error; }
+
+        private:
+            struct Mapping;
+
+            template<typename Values, typename Conditions>
+            Goal makeGoal(const Values &values, const Conditions &conditions);
+            template<typename Parameters, typename Values, typename Conditions>
+            GoalTemplate makeTemplate(const Parameters &parameters, const Values &values, const Conditions &conditions);
+
+            bool fail(const std::string &message);
+
+        private:
+            const CallbackRegistry &_registry;
+            std::shared_ptr<const CompiledDomain> _domain;
+            std::shared_ptr<SymbolTable> _symbols;
+            // Type names point into mapped image
+            const char *_strings;
+            const std::uint32_t *_typeNames;
+            std::size_t _typeCount;
+            std::string _error;
+
+        };
+    }
+}
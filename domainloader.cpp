@@ -0,0 +1,190 @@
+#include "domainloader.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+namespace ai
+{
+    namespace goap
+    {
+        DomainLoader::DomainLoader(const CallbackRegistry &registry) :
+            _registry{ registry },
+            _action{},
+            _pending{ false }
+        {
+        }
+
+        bool DomainLoader::load(std::istream &stream, Domain &domain)
+        {
+            std::string line;
+            std::size_t number{ 0 };
+
+            _error.clear();
+            _pending = false;
+
+            while (std::getline(stream, line)) {
+                ++number;
+
+                const std::size_t comment = line.find('#');
+
+                if (comment != std::string::npos)
+                    line.erase(comment);
+
+                std::istringstream tokens{ line };
+                std::string keyword;
+                std::vector<std::string> args;
+                std::string token;
+
+                if (!(tokens >> keyword))
+                    continue;
+
+                while (tokens >> token)
+                    args.push_back(token);
+
+                if (!statement(number, keyword, args, domain))
+                    return false;
+            }
+
+            if (_pending && !add(_action, domain))
+                return false;
+
+            _pending = false;
+            return true;
+        }
+
+        bool DomainLoader::loadFile(const std::string &path, Domain &domain)
+        {
+            std::ifstream file{ path };
+
+            if (!file) {
+                _error = "Can't open " + path;
+                return false;
+            }
+
+            return load(file, domain);
+        }
+
+        bool DomainLoader::statement(const std::size_t line, const std::string &keyword, std::vector<std::string> &args, Domain &domain)
+        {
+            if (keyword == "pre" || keyword == "eff") {
+                if (!_pending)
+                    return fail(line, "Condition outside of action");
+
+                if (args.empty())
+                    return fail(line, "Condition expects predicate");
+
+                ConditionDesc condition{ args[0], std::vector<std::string>(args.begin() + 1, args.end()), true };
+
+                if (condition.name[0] == '!') {
+                    condition.name.erase(0, 1);
+                    condition.state = false;
+                }
+
+                (keyword == "pre" ? _action.preconditions : _action.effects).push_back(std::move(condition));
+                return true;
+            }
+
+            // Any other statement completes previous action
+            if (_pending) {
+                _pending = false;
+
+                if (!add(_action, domain))
+                    return false;
+            }
+
+            if (keyword == "type") {
+                if (args.size() != 1)
+                    return fail(line, "Type expects name");
+
+                if (!domain.addType(args[0]))
+                    return fail(line, domain.error());
+
+                return true;
+            }
+
+            if (keyword == "predicate") {
+                if (args.empty())
+                    return fail(line, "Predicate expects name");
+
+                std::string callback{ args[0] };
+
+                if (args.size() > 1 && args.back()[0] == '@') {
+                    callback = args.back().substr(1);
+                    args.pop_back();
+                }
+
+                PredicateFunc func;
+                PredicateBatchFunc batch;
+
+                if (!_registry.predicate(callback, func, batch))
+                    return fail(line, "Registry doesn't contain " + callback + " predicate");
+
+                const std::vector<std::string> types(args.begin() + 1, args.end());
+                const bool added = batch != nullptr
+                    ? domain.addPredicate(args[0], types, batch)
+                    : domain.addPredicate(args[0], types, func);
+
+                if (!added)
+                    return fail(line, domain.error());
+
+                return true;
+            }
+
+            if (keyword == "action") {
+                if (args.size() < 2)
+                    return fail(line, "Action expects name and cost");
+
+                _action = { line, args[0], 0.0, {}, {}, {}, nullptr };
+
+                char *end;
+                _action.cost = std::strtod(args[1].c_str(), &end);
+
+                if (*end != '\0')
+                    return fail(line, "Invalid cost " + args[1]);
+
+                for (std::size_t i = 2; i < args.size(); ++i) {
+                    const std::string &arg = args[i];
+
+                    if (arg[0] == '@') {
+                        if (i + 1 != args.size())
+                            return fail(line, "Bind function must be last");
+
+                        if (!_registry.bind(arg.substr(1), _action.bind))
+                            return fail(line, "Registry doesn't contain " + arg.substr(1) + " bind function");
+
+                        continue;
+                    }
+
+                    const std::size_t colon = arg.find(':');
+
+                    if (colon == 0 || colon == std::string::npos)
+                        return fail(line, "Argument " + arg + " expects name:type");
+
+                    _action.args.push_back({ arg.substr(0, colon), arg.substr(colon + 1) });
+                }
+
+                _pending = true;
+                return true;
+            }
+
+            return fail(line, "Unknown statement " + keyword);
+        }
+
+        bool DomainLoader::add(const PendingAction &action, Domain &domain)
+        {
+            if (!domain.addAction(action.name, action.cost, action.args, action.preconditions, action.effects, action.bind))
+                return fail(action.line, domain.error());
+
+            return true;
+        }
+
+        bool DomainLoader::fail(const std::size_t line, const std::string &message)
+        {
+            std::stringstream error;
+            error << "Line " << line << ": " << message;
+            _error = error.str();
+            return false;
+        }
+    }
+}
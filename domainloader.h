@@ -0,0 +1,63 @@
+#pragma once
+
+#include "domain.h"
+#include "callbackregistry.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Reads domain from text, one statement per line, # starts comment
+        //   type object
+        //   predicate exists object
+        //   predicate inside object object @contains
+        //   action place 1 what:object where:object
+        //     pre has what
+        //     pre exists where
+        //     eff inside what where
+        //     eff !has what
+        // Callback of predicate is registered under its name unless other
+        // name follows @, @name at the end of action names bind function.
+        // Conditions belong to the last action, indentation is optional
+        class DomainLoader
+        {
+        public:
+            explicit DomainLoader(const CallbackRegistry &registry);
+
+            // Statements before failed one stay in domain,
+            // reason with line number is left in error
+            bool load(std::istream &stream, Domain &domain);
+            bool loadFile(const std::string &path, Domain &domain);
+
+            const std::string &error() const { return _error; }
+
+        private:
+            struct PendingAction
+            {
+                std::size_t line;
+                std::string name;
+                double cost;
+                std::vector<ArgDesc> args;
+                std::vector<ConditionDesc> preconditions;
+                std::vector<ConditionDesc> effects;
+                BindFunc bind;
+            };
+
+        private:
+            bool statement(const std::size_t line, const std::string &keyword, std::vector<std::string> &args, Domain &domain);
+            bool add(const PendingAction &action, Domain &domain);
+            bool fail(const std::size_t line, const std::string &message);
+
+        private:
+            const CallbackRegistry &_registry;
+            PendingAction _action;
+            bool _pending;
+            std::string _error;
+
+        };
+    }
+}
@@ -0,0 +1,180 @@
+#include "generator.h"
+
+#include <string>
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            // Same sequence everywhere, unlike standard distributions
+            std::uint64_t mix(std::uint64_t x)
+            {
+                x += 0x9E3779B97F4A7C15ull;
+                x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+                x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+                return x ^ (x >> 31);
+            }
+
+            class Random
+            {
+            public:
+                explicit Random(std::uint64_t seed) : _state{ seed } {}
+
+                std::size_t operator()(std::size_t bound)
+                {
+                    _state = mix(_state);
+                    return bound != 0 ? std::size_t(_state % bound) : 0;
+                }
+
+            private:
+                std::uint64_t _state;
+            };
+
+            std::string name(const char *prefix, std::size_t a, std::size_t b)
+            {
+                return prefix + std::to_string(a) + "_" + std::to_string(b);
+            }
+        }
+
+        Generator::Generator(const GeneratorParams &params) :
+            _params{ params },
+            _first{ 0 },
+            _actions{ 0 }
+        {
+        }
+
+        bool Generator::build(Domain &domain)
+        {
+            const GeneratorParams &p = _params;
+            Random random{ p.seed };
+
+            _first = domain.predicateCount();
+            _layers.clear();
+            _arities.clear();
+            _values.clear();
+            _actions = 0;
+
+            for (std::size_t t = 0; t < p.types; ++t) {
+                if (!domain.addType("t" + std::to_string(t)))
+                    return false;
+
+                for (std::size_t v = 0; v < p.values; ++v)
+                    _values.push_back({ name("v", t, v), "t" + std::to_string(t), Literal::entity(v) });
+            }
+
+            // First predicate of every layer has no arguments,
+            // so any action finds precondition below it
+            for (std::size_t layer = 0; layer <= p.depth; ++layer) {
+                for (std::size_t i = 0; i < p.width; ++i) {
+                    const std::size_t arity{ i == 0 || p.types == 0 ? 0 : random(p.arity + 1) };
+                    std::vector<std::string> types;
+
+                    for (std::size_t s = 0; s < arity; ++s)
+                        types.push_back("t" + std::to_string(s % p.types));
+
+                    const bool added = p.batch
+                        ? domain.addPredicate(name("p", layer, i), types, &Generator::facts)
+                        : domain.addPredicate(name("p", layer, i), types, &Generator::fact);
+
+                    if (!added)
+                        return false;
+
+                    _layers.push_back(layer);
+                    _arities.push_back(arity);
+                }
+            }
+
+            for (std::size_t layer = 1; layer <= p.depth; ++layer) {
+                for (std::size_t i = 0; i < p.width; ++i) {
+                    const std::size_t effect{ layer * p.width + i };
+                    const std::size_t arity{ _arities[effect] };
+                    std::vector<ArgDesc> args;
+                    std::vector<std::string> names;
+
+                    for (std::size_t s = 0; s < arity; ++s) {
+                        names.push_back("a" + std::to_string(s));
+                        args.push_back({ names.back(), "t" + std::to_string(s % p.types) });
+                    }
+
+                    for (std::size_t b = 0; b < p.branching; ++b) {
+                        std::vector<ConditionDesc> preconditions;
+
+                        // Slot s of precondition takes argument s,
+                        // types match as they only depend on slot
+                        for (std::size_t c = 0; c < p.preconditions; ++c) {
+                            std::size_t below{ (layer - 1) * p.width + random(p.width) };
+
+                            if (_arities[below] > arity)
+                                below = (layer - 1) * p.width;
+
+                            preconditions.push_back({
+                                "p" + std::to_string(layer - 1) + "_" + std::to_string(below % p.width),
+                                std::vector<std::string>(names.begin(), names.begin() + _arities[below]),
+                                true
+                            });
+                        }
+
+                        const double cost{ double(1 + random(p.maxCost)) };
+
+                        if (!domain.addAction(name("a", effect, b), cost, args, preconditions, { { name("p", layer, i), names, true } }))
+                            return false;
+
+                        ++_actions;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        Goal Generator::goal(Domain &domain, std::size_t index) const
+        {
+            const GeneratorParams &p = _params;
+            Random random{ mix(p.seed ^ (index + 1) * 0xD6E8FEB86659FD93ull) };
+            std::vector<ConditionDesc> conditions;
+
+            for (std::size_t f = 0; f < p.goalFacts; ++f) {
+                const std::size_t i{ random(p.width) };
+                const std::size_t predicate{ p.depth * p.width + i };
+                std::vector<std::string> args;
+
+                for (std::size_t s = 0; s < _arities[predicate]; ++s)
+                    args.push_back(name("v", s % p.types, random(p.values)));
+
+                conditions.push_back({ name("p", p.depth, i), std::move(args), true });
+            }
+
+            return domain.goal(_values, conditions);
+        }
+
+        bool Generator::fact(Agent *agent, const std::vector<Value> &values, const PredicateBind &bind)
+        {
+            const Generator &self = *static_cast<const Generator *>(agent);
+            const std::size_t predicate{ bind.id() - self._first };
+
+            if (self._layers[predicate] != 0)
+                return false;
+
+            std::uint64_t hash{ mix(self._params.seed ^ predicate) };
+
+            for (std::size_t s = 0; s < self._arities[predicate]; ++s)
+                hash = mix(hash ^ values[bind.slot(s)].data);
+
+            return hash % 100 < self._params.truth;
+        }
+
+        std::uint64_t Generator::facts(Agent *agent, const std::vector<Value> &values, const PredicateBind *binds, std::size_t count)
+        {
+            std::uint64_t result{ 0 };
+
+            for (std::size_t i = 0; i < count; ++i) {
+                if (fact(agent, values, binds[i]))
+                    result |= std::uint64_t(1) << i;
+            }
+
+            return result;
+        }
+    }
+}
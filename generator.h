@@ -0,0 +1,74 @@
+#pragma once
+
+#include "agent.h"
+#include "domain.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Predicates are stacked in layers. Facts of layer zero hold in
+        // initial state by chance, facts above it never hold and each
+        // predicate there has branching achievers, whose preconditions
+        // come from layer below. Plan of one goal fact is depth actions
+        struct GeneratorParams
+        {
+            // Slot i of predicate takes type i modulo types
+            std::size_t types = 2;
+            // Predicates per layer
+            std::size_t width = 8;
+            std::size_t depth = 4;
+            std::size_t branching = 3;
+            // Most arguments of predicate
+            std::size_t arity = 2;
+            // Objects per type, all of them are goal values
+            std::size_t values = 4;
+            std::size_t preconditions = 1;
+            std::size_t goalFacts = 2;
+            // Percent of layer zero facts which hold
+            std::size_t truth = 75;
+            // Action costs are integral, from one to this
+            std::size_t maxCost = 4;
+            std::uint64_t seed = 1;
+            // Predicates are registered with batch function
+            bool batch = false;
+        };
+
+        // Synthetic world, passed to planner as agent so
+        // predicates can tell which facts hold. Same params
+        // give the same domain and goals on every platform
+        class Generator : public Agent
+        {
+        public:
+            explicit Generator(const GeneratorParams &params);
+
+            // Adds types, predicates and actions, on failure
+            // reason is left in error of domain
+            bool build(Domain &domain);
+            // Goals differ by index, domain must be built by this generator
+            Goal goal(Domain &domain, std::size_t index) const;
+
+            const GeneratorParams &params() const { return _params; }
+            std::size_t predicateCount() const { return _layers.size(); }
+            std::size_t actionCount() const { return _actions; }
+
+        private:
+            static bool fact(Agent *agent, const std::vector<Value> &values, const PredicateBind &bind);
+            static std::uint64_t facts(Agent *agent, const std::vector<Value> &values, const PredicateBind *binds, std::size_t count);
+
+        private:
+            GeneratorParams _params;
+            // Id of first predicate, domain may hold other ones
+            std::size_t _first;
+            // Layer and arity of every predicate
+            std::vector<std::size_t> _layers;
+            std::vector<std::size_t> _arities;
+            std::vector<ValueDesc> _values;
+            std::size_t _actions;
+
+        };
+    }
+}
@@ -13,6 +13,8 @@ namespace ai
         {
             std::vector<Value> values;
             std::vector<Condition> conditions;
+            // Epoch of domain ids refer to, see Domain::epoch
+            std::uint64_t epoch = 0;
         };
     }
 }
\ No newline at end of file
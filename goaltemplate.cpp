@@ -0,0 +1,49 @@
+#include "goaltemplate.h"
+
+namespace ai
+{
+    namespace goap
+    {
+        GoalTemplate::GoalTemplate() :
+            _goal{},
+            _parameters{ 0 },
+            _valid{ false }
+        {
+        }
+
+        GoalTemplate::GoalTemplate(Goal goal, std::size_t parameters) :
+            _goal{ std::move(goal) },
+            _parameters{ parameters },
+            _valid{ true }
+        {
+        }
+
+        bool GoalTemplate::instantiate(Goal &goal, std::initializer_list<Literal> args) const
+        {
+            return instantiate(goal, args.begin(), args.size());
+        }
+
+        bool GoalTemplate::instantiate(Goal &goal, const Literal *args, std::size_t count) const
+        {
+            if (!_valid || count != _parameters)
+                return false;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                if (args[i].kind == ValueKind::Symbol && args[i].name.data() != nullptr)
+                    return false;
+            }
+
+            // Assignment keeps storage of goal, slots of conditions too
+            goal.values.assign(_goal.values.begin(), _goal.values.end());
+            goal.conditions = _goal.conditions;
+            goal.epoch = _goal.epoch;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                goal.values[i].kind = args[i].kind;
+                goal.values[i].data = args[i].data;
+            }
+
+            return true;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "goal.h"
+#include "value.h"
+
+#include <initializer_list>
+#include <cstddef>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Goal resolved from names once, its first values are parameters
+        // filled per instantiation. Goal kept by agent is instantiated
+        // in place, so replanning doesn't look names up or allocate
+        // once goal storage has grown
+        class GoalTemplate
+        {
+        public:
+            // Invalid template, made by failed compilation
+            GoalTemplate();
+            GoalTemplate(Goal goal, std::size_t parameters);
+
+            bool valid() const { return _valid; }
+            std::size_t parameterCount() const { return _parameters; }
+
+            // Type of parameter
+            std::size_t type(const std::size_t parameter) const
+            {
+                return _goal.values[parameter].type;
+            }
+
+            // Payloads of parameters in order, types come from template.
+            // Symbols are given by id, see Domain::intern. Fails on invalid
+            // template, wrong count or symbol given by name and leaves
+            // goal unchanged
+            bool instantiate(Goal &goal, std::initializer_list<Literal> args) const;
+            bool instantiate(Goal &goal, const Literal *args, std::size_t count) const;
+
+        private:
+            Goal _goal;
+            std::size_t _parameters;
+            bool _valid;
+
+        };
+    }
+}
@@ -0,0 +1,217 @@
+#include "heuristic.h"
+#include "compileddomain.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            const double infinity{ std::numeric_limits<double>::infinity() };
+            const std::size_t none{ std::size_t(-1) };
+
+            bool satisfied(const State &initial, const PredicateBind &bind, bool value)
+            {
+                return initial.contains(bind) && initial.get(bind) == value;
+            }
+        }
+
+        Heuristic::Heuristic(HeuristicType type) :
+            _type{ type },
+            _func{ nullptr },
+            _domain{ nullptr },
+            _evaluations{ 0 }
+        {
+        }
+
+        void Heuristic::setFunc(HeuristicFunc func)
+        {
+            _type = HeuristicType::Custom;
+            _func = func;
+        }
+
+        void Heuristic::prepare(const CompiledDomain &domain, const State &initial)
+        {
+            _domain = &domain;
+            _evaluations = 0;
+
+            // Built for every type, so type may change before replanning
+            const std::size_t literals = domain.predicateCount() * 2;
+
+            // Predicate literal holds for some slots unless
+            // all known facts of predicate say otherwise
+            std::vector<bool> &seen = _marked;
+            seen.assign(literals, false);
+
+            for (std::size_t i = 0; i < initial.size(); ++i)
+                seen[literal(initial.bind(i).id(), initial.value(i))] = true;
+
+            _free.assign(literals, true);
+
+            for (std::size_t p = 0; p < literals / 2; ++p) {
+                const bool any = seen[literal(p, false)] || seen[literal(p, true)];
+
+                for (const bool value : { false, true }) {
+                    if (any && !seen[literal(p, value)])
+                        _free[literal(p, value)] = false;
+                }
+            }
+
+            // Cheapest achiever ignores preconditions, so it is a lower bound
+            _max.assign(literals, infinity);
+            _add.assign(literals, infinity);
+            _support.assign(literals, none);
+
+            for (std::size_t i = 0; i < domain.actionCount(); ++i) {
+                const CompiledAction &action = domain.action(i);
+                const CompiledCondition *effects = domain.effects(action);
+
+                for (std::size_t e = 0; e < action.effects; ++e) {
+                    double &cost = _max[literal(effects[e].predicate, effects[e].state)];
+                    cost = std::min(cost, action.cost);
+                }
+            }
+
+            // Costs only decrease, so fixpoint is reached
+            // in at most one pass per literal
+            bool changed{ true };
+
+            while (changed) {
+                changed = false;
+
+                for (std::size_t i = 0; i < domain.actionCount(); ++i) {
+                    const CompiledAction &action = domain.action(i);
+                    const CompiledCondition *preconditions = domain.preconditions(action);
+                    const CompiledCondition *effects = domain.effects(action);
+                    double cost{ action.cost };
+
+                    for (std::size_t c = 0; c < action.preconditions; ++c) {
+                        const std::size_t l = literal(preconditions[c].predicate, preconditions[c].state);
+
+                        if (!_free[l])
+                            cost += _add[l];
+                    }
+
+                    if (cost == infinity)
+                        continue;
+
+                    for (std::size_t e = 0; e < action.effects; ++e) {
+                        const std::size_t l = literal(effects[e].predicate, effects[e].state);
+
+                        if (cost < _add[l]) {
+                            _add[l] = cost;
+                            _support[l] = i;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+
+            _marked.assign(literals, false);
+        }
+
+        double Heuristic::operator()(const State &state, const State &initial)
+        {
+            ++_evaluations;
+
+            switch (_type) {
+            case HeuristicType::GoalCount:
+                return state - initial;
+            case HeuristicType::Custom:
+                return _func(*_domain, state, initial);
+            case HeuristicType::FF:
+                return relaxedPlan(state, initial);
+            default:
+                break;
+            }
+
+            double result{ 0.0 };
+
+            for (std::size_t i = 0; i < state.size(); ++i) {
+                const PredicateBind bind = state.bind(i);
+
+                if (satisfied(initial, bind, state.value(i)))
+                    continue;
+
+                const std::size_t l = literal(bind.id(), state.value(i));
+
+                if (_type == HeuristicType::Max)
+                    result = std::max(result, _max[l]);
+                else
+                    result += cost(l);
+            }
+
+            return result;
+        }
+
+        double Heuristic::cost(const std::size_t literal) const
+        {
+            // Relaxation is optimistic about free literals only, so literal
+            // which has achievers is never treated as dead end
+            return _add[literal] != infinity ? _add[literal] : _max[literal];
+        }
+
+        void Heuristic::support(const std::size_t index, double &result)
+        {
+            const CompiledAction &action = (*_domain).action(index);
+            const CompiledCondition *preconditions = (*_domain).preconditions(action);
+            result += action.cost;
+
+            for (std::size_t c = 0; c < action.preconditions; ++c)
+                _stack.push_back(literal(preconditions[c].predicate, preconditions[c].state));
+        }
+
+        double Heuristic::relaxedPlan(const State &state, const State &initial)
+        {
+            double result{ 0.0 };
+
+            _stack.clear();
+            _touched.clear();
+
+            for (std::size_t i = 0; i < state.size(); ++i) {
+                const PredicateBind bind = state.bind(i);
+
+                if (satisfied(initial, bind, state.value(i)))
+                    continue;
+
+                // Facts of state are distinct, so each needs own supporter
+                const std::size_t l = literal(bind.id(), state.value(i));
+
+                if (_support[l] == none) {
+                    result += _max[l];
+                    continue;
+                }
+
+                support(_support[l], result);
+            }
+
+            // Preconditions are shared by predicate,
+            // their slots are unknown in relaxation
+            while (!_stack.empty()) {
+                const std::size_t l = _stack.back();
+                _stack.pop_back();
+
+                if (_free[l] || _marked[l])
+                    continue;
+
+                _marked[l] = true;
+                _touched.push_back(l);
+
+                if (_support[l] == none) {
+                    result += _max[l];
+                    continue;
+                }
+
+                support(_support[l], result);
+            }
+
+            for (const auto l : _touched)
+                _marked[l] = false;
+
+            return result;
+        }
+    }
+}
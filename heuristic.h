@@ -0,0 +1,78 @@
+#pragma once
+
+#include "state.h"
+
+#include <vector>
+#include <cstddef>
+
+namespace ai
+{
+    namespace goap
+    {
+        class CompiledDomain;
+
+        enum class HeuristicType
+        {
+            // Number of facts initial state doesn't satisfy
+            GoalCount,
+            // Most expensive fact to achieve, admissible
+            Max,
+            // Sum of relaxed costs of facts, not admissible
+            Add,
+            // Cost of relaxed plan with shared supporters, not admissible
+            FF,
+            // User function
+            Custom
+        };
+
+        using HeuristicFunc = double(*)(const CompiledDomain &, const State &, const State &);
+
+        // Estimates cost of reaching regressed state from initial state.
+        // Relaxed costs are computed per predicate, since slots of action
+        // preconditions are only known once they are bound. Precondition
+        // is assumed to hold unless every known fact of its predicate
+        // has the opposite value
+        class Heuristic
+        {
+        public:
+            Heuristic(HeuristicType type = HeuristicType::GoalCount);
+
+            HeuristicType type() const { return _type; }
+            void setType(HeuristicType type) { _type = type; }
+            void setFunc(HeuristicFunc func);
+
+            // Relaxed costs depend on domain and on initial
+            // state known at start of search
+            void prepare(const CompiledDomain &domain, const State &initial);
+            double operator()(const State &state, const State &initial);
+
+            std::size_t evaluations() const { return _evaluations; }
+
+        private:
+            static std::size_t literal(const std::size_t predicate, bool value)
+            {
+                return predicate * 2 + (value ? 1 : 0);
+            }
+
+            double cost(const std::size_t literal) const;
+            // Adds cost of supporter and pushes its preconditions
+            void support(const std::size_t index, double &result);
+            double relaxedPlan(const State &state, const State &initial);
+
+        private:
+            HeuristicType _type;
+            HeuristicFunc _func;
+            const CompiledDomain *_domain;
+            std::size_t _evaluations;
+            // Per literal of predicate and value
+            std::vector<bool> _free;
+            std::vector<double> _max;
+            std::vector<double> _add;
+            std::vector<std::size_t> _support;
+            std::vector<bool> _marked;
+            std::vector<std::size_t> _stack;
+            std::vector<std::size_t> _touched;
+
+        };
+    }
+}
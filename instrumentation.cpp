@@ -0,0 +1,53 @@
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace ai
+{
+    namespace goap
+    {
+        ChromeTrace::ChromeTrace(std::ostream &stream) :
+            _stream{ stream },
+            _origin{ std::chrono::steady_clock::now() },
+            _first{ true }
+        {
+            _stream << "[";
+        }
+
+        ChromeTrace::~ChromeTrace()
+        {
+            _stream << "\n]\n";
+            _stream.flush();
+        }
+
+        void ChromeTrace::span(const char *name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+        {
+            using Microseconds = std::chrono::duration<double, std::micro>;
+
+            const double ts = Microseconds(begin - _origin).count();
+            const double dur = Microseconds(end - begin).count();
+            const std::thread::id thread = std::this_thread::get_id();
+
+            std::lock_guard<std::mutex> lock{ _mutex };
+
+            // Small sequential ids read better than native ones
+            auto it = std::find(_threads.begin(), _threads.end(), thread);
+
+            if (it == _threads.end())
+                it = _threads.insert(_threads.end(), thread);
+
+            // Names are literals of planner, they need no escaping
+            const auto flags = _stream.flags();
+            const auto precision = _stream.precision();
+
+            _stream << (_first ? "\n" : ",\n") << std::fixed << std::setprecision(3)
+                << "{\"name\":\"" << name << "\",\"cat\":\"goap\",\"ph\":\"X\",\"ts\":" << ts
+                << ",\"dur\":" << dur << ",\"pid\":1,\"tid\":" << (it - _threads.begin() + 1) << "}";
+
+            _stream.flags(flags);
+            _stream.precision(precision);
+            _first = false;
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <ostream>
+#include <mutex>
+#include <thread>
+#include <cstddef>
+
+// Set to 1 to collect search profile and trace spans, with zero
+// every counter, timer and trace call compiles out
+#ifndef GOAP_INSTRUMENTATION
+#define GOAP_INSTRUMENTATION 0
+#endif
+
+#if GOAP_INSTRUMENTATION
+#define GOAP_PROFILE(...) __VA_ARGS__
+#else
+#define GOAP_PROFILE(...)
+#endif
+
+namespace ai
+{
+    namespace goap
+    {
+        struct CallbackProfile
+        {
+            std::size_t calls;
+            std::chrono::nanoseconds time;
+        };
+
+        struct SearchProfile
+        {
+            // Generated states which were already open or closed
+            std::size_t openHits;
+            std::size_t closedHits;
+            // Combinations of effect binds tried and rejected by binding
+            std::size_t combinations;
+            std::size_t bindRejections;
+            std::chrono::nanoseconds heuristic;
+            // Nodes, their states and lookup table
+            std::size_t peakNodeBytes;
+            // Indexed by predicate and action id, predicate time
+            // includes lookups in predicate cache, batch is one call
+            std::vector<CallbackProfile> predicates;
+            std::vector<CallbackProfile> binds;
+        };
+
+        // Keeps storage of callback profiles
+        inline void clear(SearchProfile &profile)
+        {
+            profile.openHits = 0;
+            profile.closedHits = 0;
+            profile.combinations = 0;
+            profile.bindRejections = 0;
+            profile.heuristic = std::chrono::nanoseconds{ 0 };
+            profile.peakNodeBytes = 0;
+
+            for (auto &callback : profile.predicates)
+                callback = { 0, std::chrono::nanoseconds{ 0 } };
+
+            for (auto &callback : profile.binds)
+                callback = { 0, std::chrono::nanoseconds{ 0 } };
+        }
+
+        inline void record(std::vector<CallbackProfile> &profiles, const std::size_t index, std::chrono::steady_clock::time_point begin)
+        {
+            if (index >= profiles.size())
+                profiles.resize(index + 1, { 0, std::chrono::nanoseconds{ 0 } });
+
+            ++profiles[index].calls;
+            profiles[index].time += std::chrono::steady_clock::now() - begin;
+        }
+
+        // Receives named spans of plan calls and their phases,
+        // sink shared between planners must be thread safe
+        class TraceSink
+        {
+        public:
+            virtual ~TraceSink() = default;
+            virtual void span(const char *name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) = 0;
+        };
+
+        // Writes complete events of Chrome trace format, file
+        // opens in chrome://tracing and Perfetto. Array is
+        // closed on destruction, one thread row per thread
+        class ChromeTrace : public TraceSink
+        {
+        public:
+            explicit ChromeTrace(std::ostream &stream);
+            ChromeTrace(const ChromeTrace &) = delete;
+            ChromeTrace &operator=(const ChromeTrace &) = delete;
+            ~ChromeTrace() override;
+
+            void span(const char *name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) override;
+
+        private:
+            std::ostream &_stream;
+            std::mutex _mutex;
+            std::chrono::steady_clock::time_point _origin;
+            std::vector<std::thread::id> _threads;
+            bool _first;
+
+        };
+
+        // Reports span from construction to end of scope
+        class TraceScope
+        {
+        public:
+            TraceScope(TraceSink *sink, const char *name) :
+                _sink{ sink },
+                _name{ name },
+                _begin{ sink != nullptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{} }
+            {
+            }
+
+            TraceScope(const TraceScope &) = delete;
+            TraceScope &operator=(const TraceScope &) = delete;
+
+            ~TraceScope()
+            {
+                if (_sink != nullptr)
+                    (*_sink).span(_name, _begin, std::chrono::steady_clock::now());
+            }
+
+        private:
+            TraceSink *_sink;
+            const char *_name;
+            std::chrono::steady_clock::time_point _begin;
+
+        };
+    }
+}
@@ -0,0 +1,219 @@
+#include "openlist.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ai
+{
+    namespace goap
+    {
+        OpenList::OpenList(OpenListType type) :
+            _type{ type },
+            _arity{ type == OpenListType::QuaternaryHeap ? 4u : 2u },
+            _size{ 0 },
+            _minBucket{ 0 }
+        {
+        }
+
+        void OpenList::setType(OpenListType type)
+        {
+            clear();
+            _type = type;
+            _arity = type == OpenListType::QuaternaryHeap ? 4 : 2;
+        }
+
+        void OpenList::clear()
+        {
+            _slots.clear();
+            _heap.clear();
+
+            // Keep bucket storage around for the next search
+            for (auto &hs : _buckets) {
+                for (auto &ids : hs)
+                    ids.clear();
+            }
+
+            _size = 0;
+            _minBucket = 0;
+        }
+
+        void OpenList::push(const std::size_t id, double g, double h)
+        {
+            if (id >= _slots.size())
+                _slots.resize(id + 1);
+
+            Slot &slot = _slots[id];
+            slot.f = g + h;
+            slot.h = h;
+            ++_size;
+
+            if (_type == OpenListType::Bucket) {
+                bucketInsert(id);
+            } else {
+                slot.position = _heap.size();
+                _heap.push_back(id);
+                siftUp(slot.position);
+            }
+        }
+
+        void OpenList::update(const std::size_t id, double g, double h)
+        {
+            Slot &slot = _slots[id];
+
+            if (_type == OpenListType::Bucket) {
+                bucketErase(id);
+                slot.f = g + h;
+                slot.h = h;
+                bucketInsert(id);
+                return;
+            }
+
+            const double f = g + h;
+            const bool decrease = f < slot.f || (f == slot.f && h < slot.h);
+            slot.f = f;
+            slot.h = h;
+
+            if (decrease)
+                siftUp(slot.position);
+            else
+                siftDown(slot.position);
+        }
+
+        std::size_t OpenList::top()
+        {
+            if (_type != OpenListType::Bucket)
+                return _heap.empty() ? npos : _heap.front();
+
+            while (_minBucket < _buckets.size()) {
+                for (auto &ids : _buckets[_minBucket]) {
+                    // LIFO inside of bucket also favours deeper nodes
+                    if (!ids.empty())
+                        return ids.back();
+                }
+
+                ++_minBucket;
+            }
+
+            return npos;
+        }
+
+        std::size_t OpenList::pop()
+        {
+            if (_type == OpenListType::Bucket) {
+                const std::size_t id = top();
+
+                if (id != npos) {
+                    bucketErase(id);
+                    --_size;
+                }
+
+                return id;
+            }
+
+            --_size;
+
+            const std::size_t id = _heap.front();
+            _slots[id].position = npos;
+
+            if (_heap.size() > 1) {
+                _heap.front() = _heap.back();
+                _slots[_heap.front()].position = 0;
+                _heap.pop_back();
+                siftDown(0);
+            } else
+                _heap.pop_back();
+
+            return id;
+        }
+
+        void OpenList::siftUp(std::size_t index)
+        {
+            const std::size_t id = _heap[index];
+
+            while (index > 0) {
+                const std::size_t parent = (index - 1) / _arity;
+
+                if (!less(id, _heap[parent]))
+                    break;
+
+                _heap[index] = _heap[parent];
+                _slots[_heap[index]].position = index;
+                index = parent;
+            }
+
+            _heap[index] = id;
+            _slots[id].position = index;
+        }
+
+        void OpenList::siftDown(std::size_t index)
+        {
+            const std::size_t id = _heap[index];
+            const std::size_t size = _heap.size();
+
+            while (true) {
+                const std::size_t first = index * _arity + 1;
+
+                if (first >= size)
+                    break;
+
+                const std::size_t last = std::min(first + _arity, size);
+                std::size_t best = first;
+
+                for (std::size_t child = first + 1; child < last; ++child) {
+                    if (less(_heap[child], _heap[best]))
+                        best = child;
+                }
+
+                if (!less(_heap[best], id))
+                    break;
+
+                _heap[index] = _heap[best];
+                _slots[_heap[index]].position = index;
+                index = best;
+            }
+
+            _heap[index] = id;
+            _slots[id].position = index;
+        }
+
+        std::vector<std::size_t> &OpenList::bucket(const Slot &slot)
+        {
+            const std::size_t f = static_cast<std::size_t>(std::lround(slot.f));
+            const std::size_t h = static_cast<std::size_t>(std::lround(slot.h));
+
+            if (f >= _buckets.size())
+                _buckets.resize(f + 1);
+
+            auto &hs = _buckets[f];
+
+            if (h >= hs.size())
+                hs.resize(h + 1);
+
+            return hs[h];
+        }
+
+        void OpenList::bucketInsert(const std::size_t id)
+        {
+            Slot &slot = _slots[id];
+            auto &ids = bucket(slot);
+            slot.position = ids.size();
+            ids.push_back(id);
+
+            const std::size_t f = static_cast<std::size_t>(std::lround(slot.f));
+
+            if (f < _minBucket)
+                _minBucket = f;
+        }
+
+        void OpenList::bucketErase(const std::size_t id)
+        {
+            Slot &slot = _slots[id];
+            auto &ids = bucket(slot);
+            const std::size_t last = ids.back();
+            ids[slot.position] = last;
+            _slots[last].position = slot.position;
+            ids.pop_back();
+            slot.position = npos;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace ai
+{
+    namespace goap
+    {
+        enum class OpenListType
+        {
+            BinaryHeap,
+            QuaternaryHeap,
+            // Dial queue, only valid for integral f and h
+            Bucket
+        };
+
+        // Open list of node ids ordered by f = g + h,
+        // ties are resolved toward lower h (deeper nodes)
+        class OpenList
+        {
+        public:
+            OpenList(OpenListType type = OpenListType::BinaryHeap);
+
+            OpenListType type() const { return _type; }
+            void setType(OpenListType type);
+
+            bool empty() const { return _size == 0; }
+            std::size_t size() const { return _size; }
+            bool contains(const std::size_t id) const
+            {
+                return id < _slots.size() && _slots[id].position != npos;
+            }
+
+            double f(const std::size_t id) const { return _slots[id].f; }
+
+            void clear();
+            void push(const std::size_t id, double g, double h);
+            void update(const std::size_t id, double g, double h);
+            std::size_t top();
+            std::size_t pop();
+
+        private:
+            static constexpr std::size_t npos = std::size_t(-1);
+
+            struct Slot
+            {
+                std::size_t position = npos;
+                double f;
+                double h;
+            };
+
+        private:
+            bool less(const std::size_t l, const std::size_t r) const
+            {
+                const Slot &ls = _slots[l];
+                const Slot &rs = _slots[r];
+                return ls.f < rs.f || (ls.f == rs.f && ls.h < rs.h);
+            }
+
+            void siftUp(std::size_t index);
+            void siftDown(std::size_t index);
+
+            void bucketInsert(const std::size_t id);
+            void bucketErase(const std::size_t id);
+            std::vector<std::size_t> &bucket(const Slot &slot);
+
+        private:
+            OpenListType _type;
+            std::size_t _arity;
+            std::size_t _size;
+            std::vector<Slot> _slots;
+            std::vector<std::size_t> _heap;
+            std::vector<std::vector<std::vector<std::size_t>>> _buckets;
+            std::size_t _minBucket;
+
+        };
+    }
+}
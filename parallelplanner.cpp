@@ -0,0 +1,481 @@
+#include "parallelplanner.h"
+#include "goal.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            const std::size_t npos{ std::size_t(-1) };
+            // Messages for one worker are sent once batch is full
+            // or every few expansions, whichever comes first
+            const std::size_t batchSize{ 64 };
+            const std::size_t flushInterval{ 8 };
+        }
+
+        ParallelPlanner::ParallelPlanner(const Domain &domain, std::size_t threads) :
+            _generation{ 0 },
+            _running{ 0 },
+            _stop{ false },
+            _goal{ nullptr },
+            _agent{ nullptr },
+            _active{ 0 },
+            _best{ std::numeric_limits<double>::infinity() },
+            _bestNode{ npos },
+            _valueCount{ 0 }
+        {
+            threads = std::max<std::size_t>(threads, 1);
+
+            for (std::size_t i = 0; i < threads; ++i) {
+                _workers.push_back(std::make_unique<Worker>(domain, i));
+                (*_workers[i]).outbox.assign(threads, nullptr);
+            }
+
+            // First worker is the calling thread
+            for (std::size_t i = 1; i < threads; ++i)
+                (*_workers[i]).thread = std::thread{ &ParallelPlanner::run, this, i };
+        }
+
+        ParallelPlanner::~ParallelPlanner()
+        {
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                _stop = true;
+            }
+
+            _start.notify_all();
+
+            for (auto &worker : _workers) {
+                if ((*worker).thread.joinable())
+                    (*worker).thread.join();
+            }
+        }
+
+        Plan ParallelPlanner::plan(const Goal &g, Agent *agent)
+        {
+            Plan result;
+            plan(g, result, agent);
+            return result;
+        }
+
+        bool ParallelPlanner::plan(const Goal &g, Plan &result, Agent *agent)
+        {
+            const std::size_t threads = _workers.size();
+
+            result.values.clear();
+            result.actions.clear();
+
+            _goal = &g;
+            _agent = agent;
+            _values.assign(g.values.begin(), g.values.end());
+            _valueCount = _values.size();
+            _best = std::numeric_limits<double>::infinity();
+            _bestNode = npos;
+            _active = threads;
+
+            // All workers have to expand with the same snapshot of domain
+            Planner &first = (*_workers[0]).planner;
+            first.refresh();
+
+            for (std::size_t i = 1; i < threads; ++i)
+                (*_workers[i]).planner._domain = first._domain;
+
+            result.epoch = (*first._domain).epoch();
+
+            // Ids of goal were shifted by removal from domain
+            if (g.epoch != result.epoch)
+                return false;
+
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                _running = threads - 1;
+                ++_generation;
+            }
+
+            _start.notify_all();
+            search(0);
+
+            {
+                std::unique_lock<std::mutex> lock{ _mutex };
+                _done.wait(lock, [this] { return _running == 0; });
+            }
+
+            if (_best == std::numeric_limits<double>::infinity())
+                return false;
+
+            // Walk back through nodes of all workers
+            std::size_t node{ _bestNode };
+
+            while (node != npos) {
+                const Planner::Node &n = (*_workers[node % threads]).planner._nodes[node / threads];
+
+                if (n.parent == npos)
+                    break;
+
+                result.actions.push_back(n.action);
+                node = n.parent;
+            }
+
+            result.values.assign(_values.begin(), _values.end());
+            return true;
+        }
+
+        std::size_t ParallelPlanner::expanded() const
+        {
+            std::size_t result{ 0 };
+
+            for (const auto &worker : _workers)
+                result += (*worker).expanded;
+
+            return result;
+        }
+
+        void ParallelPlanner::run(const std::size_t worker)
+        {
+            std::size_t generation{ 0 };
+
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock{ _mutex };
+                    _start.wait(lock, [this, generation] { return _stop || _generation != generation; });
+
+                    if (_stop)
+                        return;
+
+                    generation = _generation;
+                }
+
+                search(worker);
+
+                std::lock_guard<std::mutex> lock{ _mutex };
+
+                if (--_running == 0)
+                    _done.notify_one();
+            }
+        }
+
+        void ParallelPlanner::search(const std::size_t self)
+        {
+            Worker &worker = *_workers[self];
+            Planner &planner = worker.planner;
+            const std::size_t threads = _workers.size();
+            std::size_t expansions{ 0 };
+
+            planner._agent = _agent;
+            planner._nodeStorage = NodeStorage::Full;
+            planner.reset();
+            planner._values.clear();
+            worker.values = 0;
+            worker.expanded = 0;
+            synchronize(worker);
+
+            State initial{ &planner._arena };
+            State goal{ &planner._arena };
+            State successor{ &planner._arena };
+
+            // Every worker evaluates initial state by itself,
+            // but only owner of goal state starts the search
+            planner.prepare(*_goal, initial, goal);
+            planner._heuristic.prepare(*planner._domain, initial);
+
+            if (owner(goal.hash()) == self) {
+                if (initial == goal)
+                    found(npos, 0.0);
+                else
+                    insert(worker, goal, 0.0, {}, npos, initial);
+            }
+
+            while (true) {
+                receive(worker, initial);
+
+                const std::size_t currentId = planner._open.top();
+
+                if (currentId != npos && planner._open.f(currentId) < _best.load(std::memory_order_relaxed)) {
+                    planner._open.pop();
+                    planner._current = planner._states[currentId];
+                    planner._currentId = currentId;
+                    ++worker.expanded;
+
+                    const double g = planner._nodes[currentId].g;
+                    const std::size_t parent = currentId * threads + self;
+
+                    // Goal is only accepted on expansion, same as serial search
+                    if (planner._current.meets(initial)) {
+                        found(parent, g);
+                        continue;
+                    }
+
+                    planner.expand(planner._current, successor, [&](State &outcome, ActionBind &actionBind, const CompiledAction &action) {
+                        // Values added by bind function must be visible to every worker
+                        if (planner._values.size() != worker.values && !publish(worker, outcome, actionBind))
+                            return;
+
+                        const std::size_t to = owner(outcome.hash());
+
+                        if (to == self)
+                            insert(worker, outcome, g + action.cost, actionBind, parent, initial);
+                        else
+                            send(worker, to, outcome, g + action.cost, actionBind, parent);
+                    });
+
+                    if (++expansions % flushInterval == 0)
+                        flush(worker);
+
+                    continue;
+                }
+
+                flush(worker);
+
+                if (worker.inbox.load(std::memory_order_acquire) != nullptr)
+                    continue;
+
+                // Nothing below best cost, go idle. Last idle
+                // worker with no batch in flight ends the search
+                if (_active.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    break;
+
+                while (worker.inbox.load(std::memory_order_acquire) == nullptr &&
+                    _active.load(std::memory_order_acquire) != 0)
+                    std::this_thread::yield();
+
+                // Batch in inbox is still counted, so search can't be over
+                if (worker.inbox.load(std::memory_order_acquire) == nullptr)
+                    break;
+
+                _active.fetch_add(1, std::memory_order_acq_rel);
+            }
+
+            planner._currentId = npos;
+        }
+
+        void ParallelPlanner::receive(Worker &worker, State &initial)
+        {
+            Batch *batch = worker.inbox.exchange(nullptr, std::memory_order_acquire);
+
+            if (batch == nullptr)
+                return;
+
+            // States may use values published after last synchronization
+            synchronize(worker);
+
+            while (batch != nullptr) {
+                Batch *next = batch->next;
+
+                for (std::size_t i = 0; i < batch->size; ++i) {
+                    Message &message = batch->messages[i];
+                    insert(worker, message.state, message.g, message.action, message.parent, initial);
+                }
+
+                batch->size = 0;
+
+                // Give batch back to its owner
+                std::atomic<Batch *> &returned = (*_workers[batch->owner]).returned;
+                batch->next = returned.load(std::memory_order_relaxed);
+
+                while (!returned.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed))
+                    ;
+
+                _active.fetch_sub(1, std::memory_order_acq_rel);
+                batch = next;
+            }
+        }
+
+        void ParallelPlanner::insert(Worker &worker, const State &state, double g, const ActionBind &action, std::size_t parent, State &initial)
+        {
+            Planner &planner = worker.planner;
+
+            planner.updateState(state, initial);
+
+            const double h = planner._heuristic(state, initial);
+
+            // Also drops dead ends with infinite estimate
+            if (g + h >= _best.load(std::memory_order_relaxed))
+                return;
+
+            const std::size_t existing = planner.find(state);
+
+            if (existing == npos) {
+                const std::size_t index = planner._nodes.size();
+                planner._nodes.push_back({ g, h, action, parent, state.hash() });
+                planner.insert(index);
+                planner._open.push(index, g, h);
+                planner._states.emplace_back(&planner._arena);
+                planner._states.back() = state;
+                return;
+            }
+
+            Planner::Node &node = planner._nodes[existing];
+
+            if (g >= node.g)
+                return;
+
+            node.g = g;
+            node.h = h;
+            node.action = action;
+            node.parent = parent;
+
+            // Nodes are expanded out of global order,
+            // so closed node may be reached by shorter path
+            if (planner._open.contains(existing))
+                planner._open.update(existing, g, h);
+            else
+                planner._open.push(existing, g, h);
+        }
+
+        void ParallelPlanner::send(Worker &worker, const std::size_t to, const State &state, double g, const ActionBind &action, std::size_t parent)
+        {
+            Batch *&batch = worker.outbox[to];
+
+            if (batch == nullptr)
+                batch = acquire(worker);
+
+            if (batch->size == batch->messages.size())
+                batch->messages.push_back({ State{}, 0.0, {}, npos });
+
+            Message &message = batch->messages[batch->size++];
+            message.state = state;
+            message.g = g;
+            message.action = action;
+            message.parent = parent;
+
+            if (batch->size == batchSize)
+                flush(worker, to);
+        }
+
+        void ParallelPlanner::flush(Worker &worker, const std::size_t to)
+        {
+            Batch *batch = worker.outbox[to];
+
+            if (batch == nullptr || batch->size == 0)
+                return;
+
+            worker.outbox[to] = nullptr;
+
+            // Count batch before it becomes visible to receiver
+            _active.fetch_add(1, std::memory_order_acq_rel);
+
+            std::atomic<Batch *> &inbox = (*_workers[to]).inbox;
+            batch->next = inbox.load(std::memory_order_relaxed);
+
+            while (!inbox.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed))
+                ;
+        }
+
+        void ParallelPlanner::flush(Worker &worker)
+        {
+            for (std::size_t i = 0; i < worker.outbox.size(); ++i)
+                flush(worker, i);
+        }
+
+        void ParallelPlanner::synchronize(Worker &worker)
+        {
+            std::vector<Value> &values = worker.planner._values;
+
+            // Unpublished local values would shift shared ones
+            values.resize(worker.values);
+
+            if (_valueCount.load(std::memory_order_acquire) == worker.values)
+                return;
+
+            std::lock_guard<std::mutex> lock{ _valueMutex };
+            values.insert(values.end(), _values.begin() + worker.values, _values.end());
+            worker.values = values.size();
+        }
+
+        bool ParallelPlanner::publish(Worker &worker, State &state, ActionBind &action)
+        {
+            std::vector<Value> &values = worker.planner._values;
+            const std::size_t first = worker.values;
+            const std::size_t last = values.size();
+
+            std::lock_guard<std::mutex> lock{ _valueMutex };
+            const std::size_t offset = _values.size();
+
+            // Moved values wouldn't fit slots, drop the successor
+            if (offset + last - first > PredicateBind::MaxValues) {
+                values.resize(first);
+                return false;
+            }
+
+            _values.insert(_values.end(), values.begin() + first, values.end());
+
+            // Other worker was first, move new values after its ones
+            if (offset != first) {
+                const auto move = [first, last, offset](auto &bind) {
+                    for (std::size_t i = 0; i < bind.Arity; ++i) {
+                        const std::size_t slot = bind.slot(i);
+
+                        if (bind.bound(i) && slot >= first && slot < last)
+                            bind.setSlot(i, slot - first + offset);
+                    }
+                };
+
+                State &remap = worker.remap;
+                remap = State{};
+
+                for (std::size_t i = 0; i < state.size(); ++i) {
+                    PredicateBind bind = state.bind(i);
+                    move(bind);
+
+                    remap.set(bind, state.value(i));
+                }
+
+                state = remap;
+
+                move(action);
+
+                values.resize(first);
+                values.insert(values.end(), _values.begin() + first, _values.end());
+            }
+
+            worker.values = values.size();
+            _valueCount.store(_values.size(), std::memory_order_release);
+
+            return true;
+        }
+
+        void ParallelPlanner::found(const std::size_t node, double cost)
+        {
+            std::lock_guard<std::mutex> lock{ _bestMutex };
+
+            if (cost < _best.load(std::memory_order_relaxed)) {
+                _bestNode = node;
+                _best.store(cost, std::memory_order_relaxed);
+            }
+        }
+
+        ParallelPlanner::Batch *ParallelPlanner::acquire(Worker &worker)
+        {
+            if (worker.pool.empty()) {
+                Batch *batch = worker.returned.exchange(nullptr, std::memory_order_acquire);
+
+                while (batch != nullptr) {
+                    worker.pool.push_back(batch);
+                    batch = batch->next;
+                }
+            }
+
+            if (worker.pool.empty()) {
+                worker.batches.push_back(std::make_unique<Batch>());
+                Batch *batch = worker.batches.back().get();
+                batch->owner = worker.index;
+                batch->messages.reserve(batchSize);
+                return batch;
+            }
+
+            Batch *batch = worker.pool.back();
+            worker.pool.pop_back();
+            return batch;
+        }
+
+        std::size_t ParallelPlanner::owner(const std::uint64_t hash) const
+        {
+            // High bits, low ones pick slot in owner's node index
+            return static_cast<std::size_t>(((hash >> 32) * _workers.size()) >> 32);
+        }
+    }
+}
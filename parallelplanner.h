@@ -0,0 +1,125 @@
+#pragma once
+
+#include "planner.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Single search spread over many threads (hash distributed A*).
+        // Every state is owned by one worker chosen by its fingerprint,
+        // successors of other workers are sent to owner through lock-free
+        // inboxes. Search ends when no worker has a node below best found
+        // cost and no message is in flight, so cost of plan is the same
+        // as of serial planner. Predicates and bind functions must be
+        // thread safe, node storage is always full
+        class ParallelPlanner
+        {
+        public:
+            ParallelPlanner(const Domain &domain, std::size_t threads = std::thread::hardware_concurrency());
+            ParallelPlanner(const ParallelPlanner &) = delete;
+            ParallelPlanner &operator=(const ParallelPlanner &) = delete;
+            ~ParallelPlanner();
+
+            // Calling thread takes part as the first worker
+            Plan plan(const Goal &goal, Agent *agent = nullptr);
+            bool plan(const Goal &goal, Plan &plan, Agent *agent = nullptr);
+
+            std::size_t threads() const { return _workers.size(); }
+            Planner &planner(const std::size_t worker) { return (*_workers[worker]).planner; }
+
+            // Nodes expanded by all workers during last plan
+            std::size_t expanded() const;
+
+        private:
+            struct Message
+            {
+                State state;
+                double g;
+                ActionBind action;
+                std::size_t parent;
+            };
+
+            // Messages are sent in batches, batch goes back
+            // to its owner once receiver has consumed it
+            struct Batch
+            {
+                Batch *next = nullptr;
+                std::size_t owner;
+                std::size_t size = 0;
+                std::vector<Message> messages;
+            };
+
+            struct Worker
+            {
+                Worker(const Domain &domain, const std::size_t index) :
+                    planner{ domain },
+                    index{ index },
+                    inbox{ nullptr },
+                    returned{ nullptr },
+                    values{ 0 },
+                    expanded{ 0 }
+                {
+                }
+
+                Planner planner;
+                std::size_t index;
+                std::atomic<Batch *> inbox;
+                std::atomic<Batch *> returned;
+                // Owner only
+                std::vector<Batch *> pool;
+                std::vector<Batch *> outbox;
+                std::vector<std::unique_ptr<Batch>> batches;
+                State remap;
+                // Prefix of shared value table known to planner
+                std::size_t values;
+                std::size_t expanded;
+                std::thread thread;
+            };
+
+        private:
+            void run(const std::size_t worker);
+            void search(const std::size_t worker);
+            void receive(Worker &worker, State &initial);
+            void insert(Worker &worker, const State &state, double g, const ActionBind &action, std::size_t parent, State &initial);
+            void send(Worker &worker, const std::size_t to, const State &state, double g, const ActionBind &action, std::size_t parent);
+            void flush(Worker &worker, const std::size_t to);
+            void flush(Worker &worker);
+            void synchronize(Worker &worker);
+            bool publish(Worker &worker, State &state, ActionBind &action);
+            void found(const std::size_t node, double cost);
+            Batch *acquire(Worker &worker);
+            std::size_t owner(const std::uint64_t hash) const;
+
+        private:
+            std::vector<std::unique_ptr<Worker>> _workers;
+            std::mutex _mutex;
+            std::condition_variable _start;
+            std::condition_variable _done;
+            std::size_t _generation;
+            std::size_t _running;
+            bool _stop;
+            const Goal *_goal;
+            Agent *_agent;
+            // Active workers plus batches in flight,
+            // search is over once it drops to zero
+            std::atomic<std::size_t> _active;
+            // Best plan so far, node id is packed with its worker
+            std::atomic<double> _best;
+            std::size_t _bestNode;
+            std::mutex _bestMutex;
+            // Values appended by bind functions are shared by all workers
+            std::vector<Value> _values;
+            std::atomic<std::size_t> _valueCount;
+            std::mutex _valueMutex;
+
+        };
+    }
+}
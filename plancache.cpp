@@ -0,0 +1,196 @@
+#include "plancache.h"
+
+#include <algorithm>
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            std::uint64_t combine(std::uint64_t seed, std::uint64_t value)
+            {
+                return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+            }
+        }
+
+        PlanCache::PlanCache(std::size_t capacity) :
+            _capacity{ std::max<std::size_t>(capacity, 1) },
+            _shards{ new Shard[ShardCount] },
+            _clock{ 0 },
+            _hits{ 0 },
+            _misses{ 0 },
+            _evictions{ 0 },
+            _invalidations{ 0 }
+        {
+        }
+
+        void PlanCache::insert(
+            const CompiledDomain &domain,
+            const Goal &goal,
+            const State &facts,
+            const std::vector<Value> &values,
+            const Plan &plan,
+            bool found
+        )
+        {
+            const std::uint64_t key = hash(goal);
+            Shard &shard = _shards[key % ShardCount];
+            std::unique_lock<std::shared_mutex> lock{ shard.mutex };
+            Bucket &bucket = shard.buckets[key];
+
+            Entries entries;
+
+            // Colliding goal takes the bucket over
+            if (!equal(bucket.goal, goal)) {
+                if (bucket.entries != nullptr)
+                    shard.size -= (*bucket.entries).size();
+
+                bucket.goal = goal;
+            } else if (bucket.entries != nullptr)
+                entries = *bucket.entries;
+
+            const auto stale = std::remove_if(entries.begin(), entries.end(), [&domain, &facts](const std::shared_ptr<Entry> &entry) {
+                return (*entry).version != domain.version() || (*entry).facts == facts;
+            });
+
+            for (auto it = stale; it != entries.end(); ++it) {
+                if ((**it).version != domain.version())
+                    ++_invalidations;
+            }
+
+            shard.size -= entries.end() - stale;
+            entries.erase(stale, entries.end());
+
+            const auto entry = std::make_shared<Entry>();
+            (*entry).version = domain.version();
+            (*entry).facts = facts;
+            (*entry).values = values;
+            (*entry).actions = plan.actions;
+            (*entry).found = found;
+            (*entry).used = ++_clock;
+            entries.push_back(entry);
+            ++shard.size;
+
+            bucket.entries = std::make_shared<const Entries>(std::move(entries));
+
+            // Capacity is split evenly between shards
+            const std::size_t limit = std::max<std::size_t>(_capacity / ShardCount, 1);
+
+            while (shard.size > limit)
+                evict(shard);
+        }
+
+        void PlanCache::clear()
+        {
+            for (std::size_t i = 0; i < ShardCount; ++i) {
+                Shard &shard = _shards[i];
+                std::unique_lock<std::shared_mutex> lock{ shard.mutex };
+                shard.buckets.clear();
+                shard.size = 0;
+            }
+        }
+
+        std::size_t PlanCache::size() const
+        {
+            std::size_t result{ 0 };
+
+            for (std::size_t i = 0; i < ShardCount; ++i) {
+                const Shard &shard = _shards[i];
+                std::shared_lock<std::shared_mutex> lock{ shard.mutex };
+                result += shard.size;
+            }
+
+            return result;
+        }
+
+        void PlanCache::resetStatistics()
+        {
+            _hits = 0;
+            _misses = 0;
+            _evictions = 0;
+            _invalidations = 0;
+        }
+
+        std::uint64_t PlanCache::hash(const Goal &goal)
+        {
+            std::uint64_t key{ goal.conditions.size() };
+
+            for (const auto &condition : goal.conditions) {
+                key = combine(key, condition.index);
+                key = combine(key, condition.state);
+
+                for (const auto slot : condition.slots)
+                    key = combine(key, slot);
+            }
+
+            for (const auto &value : goal.values) {
+                key = combine(key, value.type);
+                key = combine(key, static_cast<std::uint64_t>(value.kind));
+                key = combine(key, value.data);
+            }
+
+            return key;
+        }
+
+        bool PlanCache::equal(const Goal &l, const Goal &r)
+        {
+            if (l.conditions.size() != r.conditions.size() || l.values.size() != r.values.size())
+                return false;
+
+            for (std::size_t i = 0; i < l.conditions.size(); ++i) {
+                const Condition &lc = l.conditions[i];
+                const Condition &rc = r.conditions[i];
+
+                if (lc.index != rc.index || lc.state != rc.state || lc.slots != rc.slots)
+                    return false;
+            }
+
+            for (std::size_t i = 0; i < l.values.size(); ++i) {
+                if (l.values[i] != r.values[i])
+                    return false;
+            }
+
+            return true;
+        }
+
+        void PlanCache::evict(Shard &shard)
+        {
+            // Approximate LRU, hits only touch entry clock under shared lock
+            auto oldestBucket = shard.buckets.end();
+            std::size_t oldestEntry{ 0 };
+            std::uint64_t oldest{ std::uint64_t(-1) };
+
+            for (auto it = shard.buckets.begin(); it != shard.buckets.end(); ++it) {
+                if ((*it).second.entries == nullptr)
+                    continue;
+
+                const Entries &entries = *(*it).second.entries;
+
+                for (std::size_t i = 0; i < entries.size(); ++i) {
+                    const std::uint64_t used = (*entries[i]).used.load(std::memory_order_relaxed);
+
+                    if (used < oldest) {
+                        oldest = used;
+                        oldestBucket = it;
+                        oldestEntry = i;
+                    }
+                }
+            }
+
+            if (oldestBucket == shard.buckets.end())
+                return;
+
+            // Lookups in progress keep previous entries
+            Entries entries = *(*oldestBucket).second.entries;
+            entries.erase(entries.begin() + oldestEntry);
+            --shard.size;
+            ++_evictions;
+
+            if (entries.empty())
+                shard.buckets.erase(oldestBucket);
+            else
+                (*oldestBucket).second.entries = std::make_shared<const Entries>(std::move(entries));
+        }
+    }
+}
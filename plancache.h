@@ -0,0 +1,153 @@
+#pragma once
+
+#include "domain.h"
+#include "plan.h"
+#include "state.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Bounded cache of search results shared by many planners of one
+        // domain. Entries are keyed by goal, entry matches only when every
+        // initial state fact its search evaluated still has the same value,
+        // so result is the same as of a new search. Least recently used
+        // entries are evicted, entries of older domain version are stale
+        class PlanCache
+        {
+        public:
+            PlanCache(std::size_t capacity = 1024);
+            PlanCache(const PlanCache &) = delete;
+            PlanCache &operator=(const PlanCache &) = delete;
+
+            // Evaluate is bool(const std::vector<Value> &, const PredicateBind &),
+            // values are the ones plan was found with. Returns true on hit and
+            // fills found with result of cached search
+            template<typename Evaluate>
+            bool find(const CompiledDomain &domain, const Goal &goal, Evaluate &&evaluate, Plan &plan, bool &found);
+
+            // Facts are evaluated initial state facts of finished search
+            void insert(
+                const CompiledDomain &domain,
+                const Goal &goal,
+                const State &facts,
+                const std::vector<Value> &values,
+                const Plan &plan,
+                bool found
+            );
+
+            void clear();
+
+            std::size_t capacity() const { return _capacity; }
+            std::size_t size() const;
+            std::size_t hits() const { return _hits; }
+            std::size_t misses() const { return _misses; }
+            std::size_t evictions() const { return _evictions; }
+            // Entries dropped since domain has changed
+            std::size_t invalidations() const { return _invalidations; }
+            void resetStatistics();
+
+        private:
+            struct Entry
+            {
+                std::uint64_t version;
+                State facts;
+                std::vector<Value> values;
+                std::vector<ActionBind> actions;
+                bool found;
+                std::atomic<std::uint64_t> used;
+            };
+
+            // Entries of bucket are replaced, never changed in place, so
+            // lookup takes them and evaluates facts without holding lock
+            using Entries = std::vector<std::shared_ptr<Entry>>;
+
+            struct Bucket
+            {
+                Goal goal;
+                std::shared_ptr<const Entries> entries;
+            };
+
+            // Lookups only share lock of a shard
+            struct Shard
+            {
+                mutable std::shared_mutex mutex;
+                std::unordered_map<std::uint64_t, Bucket> buckets;
+                std::size_t size = 0;
+            };
+
+        private:
+            static constexpr std::size_t ShardCount = 16;
+
+            static std::uint64_t hash(const Goal &goal);
+            static bool equal(const Goal &l, const Goal &r);
+
+            void evict(Shard &shard);
+
+        private:
+            std::size_t _capacity;
+            std::unique_ptr<Shard[]> _shards;
+            std::atomic<std::uint64_t> _clock;
+            std::atomic<std::size_t> _hits;
+            std::atomic<std::size_t> _misses;
+            std::atomic<std::size_t> _evictions;
+            std::atomic<std::size_t> _invalidations;
+
+        };
+
+        template<typename Evaluate>
+        bool PlanCache::find(const CompiledDomain &domain, const Goal &goal, Evaluate &&evaluate, Plan &plan, bool &found)
+        {
+            const std::uint64_t key = hash(goal);
+            Shard &shard = _shards[key % ShardCount];
+            std::shared_ptr<const Entries> entries;
+
+            // Predicates are user code, they are not called under lock
+            {
+                std::shared_lock<std::shared_mutex> lock{ shard.mutex };
+                const auto it = shard.buckets.find(key);
+
+                if (it != shard.buckets.end() && equal((*it).second.goal, goal))
+                    entries = (*it).second.entries;
+            }
+
+            if (entries != nullptr) {
+                for (const auto &entry : *entries) {
+                    if ((*entry).version != domain.version())
+                        continue;
+
+                    const State &facts = (*entry).facts;
+                    std::size_t i{ 0 };
+
+                    // Stop on first fact which doesn't hold anymore
+                    while (i < facts.size() && evaluate((*entry).values, facts.bind(i)) == facts.value(i))
+                        ++i;
+
+                    if (i != facts.size())
+                        continue;
+
+                    (*entry).used.store(++_clock, std::memory_order_relaxed);
+                    found = (*entry).found;
+                    plan.actions.assign((*entry).actions.begin(), (*entry).actions.end());
+
+                    if (found)
+                        plan.values.assign((*entry).values.begin(), (*entry).values.end());
+
+                    ++_hits;
+                    return true;
+                }
+            }
+
+            ++_misses;
+            return false;
+        }
+    }
+}
@@ -5,6 +5,8 @@
 #include <array>
 #include <set>
 #include <iostream>
+#include <cmath>
+#include <limits>
 
 namespace ai
 {
@@ -14,162 +16,560 @@ namespace ai
         {
             PredicateBind from(const Condition &c)
             {
-                PredicateBind bind{ static_cast<std::uint8_t>(c.index) };
+                PredicateBind bind{ c.index };
                 
                 for (std::size_t i = 0; i < c.slots.size(); ++i)
-                    bind.slots[i] = static_cast<std::uint8_t>(c.slots[i]);
+                    bind.setSlot(i, c.slots[i]);
 
                 return bind;
             }
+
+            void print(const SymbolTable &symbols, const Value &value)
+            {
+                switch (value.kind) {
+                case ValueKind::Symbol:
+                    std::cout << symbols.name(value.asSymbol());
+                    break;
+                case ValueKind::Integer:
+                    std::cout << value.asInteger();
+                    break;
+                case ValueKind::Real:
+                    std::cout << value.asReal();
+                    break;
+                case ValueKind::Entity:
+                    std::cout << "#" << value.asEntity();
+                    break;
+                default:
+                    std::cout << "?";
+                    break;
+                }
+            }
         }
 
-        Planner::Planner(const Domain &domain) :
-            _domain{ domain }
+        Planner::Planner(const Domain &domain, OpenListType openList) :
+            Planner(domain.compile(), openList)
         {
+            _source = &domain;
         }
 
-        Plan Planner::plan(const Goal &g)
+        Planner::Planner(std::shared_ptr<const CompiledDomain> domain, OpenListType openList) :
+            _source{ nullptr },
+            _domain{ std::move(domain) },
+            _openListType{ openList },
+            _nodeStorage{ NodeStorage::Full },
+            _predicateCache{ nullptr },
+            _planCache{ nullptr },
+            _statistics{ HeuristicType::GoalCount, 0, 0, 0, 0.0, 0.0, false },
+            _weight{ 1.0 },
+            _iteration{ 0 },
+            _best{ std::size_t(-1) },
+            _agent{ nullptr },
+            _cacheNext{ 0 },
+            _currentId{ std::size_t(-1) }
         {
-            State initial;
-            State goal;
+        }
 
-            // First create goal state and
-            // calculate initial state
-            for (const auto &c : g.conditions) {
-                const PredicateBind bind = from(c);
-                goal.set(bind, c.state);
-                const Predicate &predicate = _domain.predicate(c.index);
-                const bool state = predicate(nullptr, g.values, bind);
-                initial.set(bind, state);
+        Plan Planner::plan(const Goal &g, Agent *agent)
+        {
+            Plan result;
+            plan(g, result, agent);
+            return result;
+        }
+
+        bool Planner::plan(const Goal &g, Plan &result, Agent *agent)
+        {
+            result.values.clear();
+            result.actions.clear();
+            _agent = agent;
+            begin();
+            GOAP_PROFILE(TraceScope trace{ _trace, "plan" });
+
+            refresh();
+            reset();
+
+            // Kept for replanning, assign keeps already allocated storage
+            _initial = State{};
+            _goal = State{};
+            _values.assign(g.values.begin(), g.values.end());
+            result.epoch = (*_domain).epoch();
+
+            // Ids of goal were shifted by removal from domain
+            if (g.epoch != result.epoch)
+                return false;
+
+            if (_planCache != nullptr) {
+                const auto evaluate = [this](const std::vector<Value> &values, const PredicateBind &bind) {
+                    return this->evaluate(values, bind);
+                };
+                bool found;
+
+                if (_planCache->find(*_domain, g, evaluate, result, found)) {
+                    // Nothing is searched, so replanning starts from goal
+                    for (const auto &c : g.conditions)
+                        _goal.set(from(c), c.state);
+
+                    // Only final results are stored
+                    if (found) {
+                        _statistics.cost = 0.0;
+                        _statistics.bound = 1.0;
+
+                        for (const auto &action : result.actions)
+                            _statistics.cost += (*_domain).action(action.id()).cost;
+                    }
+
+                    return found;
+                }
             }
 
+            prepare(g, _initial, _goal);
+
             // If we already meet our goal return
-            if (initial == goal)
-                return{};
+            if (_initial == _goal) {
+                _statistics.cost = 0.0;
+                _statistics.bound = 1.0;
+                return true;
+            }
 
-            _nodes.clear();
-            _open.clear();
-            _closed.clear();
-            _values.clear();
+            start();
+
+            const bool found = anytime(result);
+
+            // Plan of weighted or unfinished search may still improve
+            if (_planCache != nullptr && !_statistics.exhausted && (_weight == 1.0 || !found))
+                _planCache->insert(*_domain, g, _initial, _values, result, found);
+
+            return found;
+        }
+
+        bool Planner::improve(Plan &result, Agent *agent)
+        {
+            result.values.clear();
+            result.actions.clear();
+            result.epoch = (*_domain).epoch();
+            _agent = agent;
+
+            const bool suspended{ _statistics.exhausted };
+            begin();
+            GOAP_PROFILE(TraceScope trace{ _trace, "improve" });
+
+            // Nothing was searched, plan came from cache or goal already holds
+            if (_nodes.empty())
+                return false;
+
+            // Last iteration is complete, look for plan with lower bound
+            if (!suspended && _best != std::size_t(-1) && _weight > 1.0)
+                tighten();
+
+            return anytime(result);
+        }
+
+        bool Planner::replan(const std::vector<PredicateBind> &changed, Plan &result, Agent *agent)
+        {
+            result.values.clear();
+            result.actions.clear();
+            result.epoch = (*_domain).epoch();
+            _agent = agent;
+            _changed.clear();
+            begin();
+            GOAP_PROFILE(TraceScope trace{ _trace, "replan" });
+
+            // Facts not in initial state are not used by
+            // any node yet and will be evaluated on demand
+            for (const auto &bind : changed) {
+                if (!_initial.contains(bind))
+                    continue;
+
+                const bool value = evaluate(bind);
+
+                if (value != _initial.get(bind)) {
+                    _initial.set(bind, value);
+                    _changed.push_back(bind);
+                }
+            }
+
+            if (_nodes.empty()) {
+                // Goal facts are not evaluated when plan came from cache
+                updateState(_goal, _initial);
+
+                if (_goal.meets(_initial))
+                    return true;
+
+                start();
+                search();
+                return finish(result);
+            }
+
+            // Graph of regressed states doesn't depend on initial state,
+            // only distance to it does. Relaxation is built again, h of
+            // open nodes is repaired and closed nodes which now meet
+            // initial state become goals. Goals which no longer hold
+            // were never expanded, so they are opened again
+            _reopened.clear();
+
+            for (const auto id : _goals) {
+                if (!state(id).meets(_initial))
+                    _reopened.push_back(id);
+            }
+
+            _goals.erase(std::remove_if(_goals.begin(), _goals.end(), [this](const std::size_t id) {
+                return std::find(_reopened.begin(), _reopened.end(), id) != _reopened.end();
+            }), _goals.end());
+
+            if (!_changed.empty())
+                _heuristic.prepare(*_domain, _initial);
+
+            // Relaxed estimates depend on whole initial state
+            const bool relaxed = _heuristic.type() != HeuristicType::GoalCount;
+
+            for (std::size_t id = 0; id < _nodes.size() && !_changed.empty(); ++id) {
+                const State &state = this->state(id);
+                const auto affected = std::find_if(_changed.begin(), _changed.end(), [&state](const PredicateBind &bind) {
+                    return state.contains(bind);
+                });
+
+                if (affected == _changed.end() && !relaxed)
+                    continue;
+
+                Node &node = _nodes[id];
+
+                if (_open.contains(id)) {
+                    const double h = estimate(state);
+
+                    // Dead end keeps its old estimate, it can't be removed from open list
+                    if (h != std::numeric_limits<double>::infinity()) {
+                        node.h = h;
+                        _open.update(id, node.g, _weight * node.h);
+                    }
+                } else if (parkedNode(id)) {
+                    // Dead end may be reachable from new initial state
+                    node.h = estimate(state);
+
+                    if (node.h != std::numeric_limits<double>::infinity())
+                        _open.push(id, node.g, _weight * node.h);
+                } else if (affected != _changed.end() && state.meets(_initial) && std::find(_goals.begin(), _goals.end(), id) == _goals.end())
+                    _goals.push_back(id);
+            }
+
+            for (const auto id : _reopened) {
+                Node &node = _nodes[id];
+                node.h = estimate(state(id));
+
+                if (node.h != std::numeric_limits<double>::infinity())
+                    _open.push(id, node.g, _weight * node.h);
+            }
+
+            _best = std::size_t(-1);
 
-            _values = g.values;
+            for (const auto id : _goals) {
+                if (_best == std::size_t(-1) || _nodes[id].g < _nodes[_best].g)
+                    _best = id;
+            }
+
+            search();
+            return finish(result);
+        }
+
+        void Planner::start()
+        {
+            GOAP_PROFILE(TraceScope trace{ _trace, "start" });
+            GOAP_PROFILE(const auto relaxation = std::chrono::steady_clock::now());
+            _heuristic.prepare(*_domain, _initial);
+            GOAP_PROFILE(_profile.heuristic += std::chrono::steady_clock::now() - relaxation);
 
             // Create first node
-            _open.push_back(_nodes.size());
-            _nodes.push_back({ goal, 0.0, initial - goal });
+            _nodes.push_back({ 0.0, estimate(_goal), {}, std::size_t(-1), _goal.hash() });
+            insert(0);
+            _open.push(0, _nodes[0].g, _weight * _nodes[0].h);
+
+            State goal{ &_arena };
+            goal = _goal;
+            store(_nodes[0], State{}, goal);
+        }
+
+        void Planner::begin()
+        {
+            _statistics = {
+                _heuristic.type(),
+                0,
+                0,
+                0,
+                std::numeric_limits<double>::infinity(),
+                std::numeric_limits<double>::infinity(),
+                false
+            };
+
+            if (_limits.time.count() != 0)
+                _deadline = std::chrono::steady_clock::now() + _limits.time;
+
+            GOAP_PROFILE(clear(_profile));
+        }
+
+        bool Planner::exhausted()
+        {
+            const std::size_t expanded{ _statistics.expanded };
+
+            if (_limits.expansions != 0 && expanded >= _limits.expansions)
+                return true;
+
+            // Clock is read every few expansions only
+            return _limits.time.count() != 0 && expanded % 16 == 0 && std::chrono::steady_clock::now() >= _deadline;
+        }
+
+        bool Planner::anytime(Plan &result)
+        {
+            // Every complete iteration gives plan within weight,
+            // keep tightening it while limits allow
+            while (search() && _best != std::size_t(-1) && _weight > 1.0)
+                tighten();
+
+            return finish(result);
+        }
+
+        bool Planner::search()
+        {
+            GOAP_PROFILE(TraceScope trace{ _trace, "search" });
+            State successor{ &_arena };
+
+            // Nodes which are not in open list are closed
+            while (!_open.empty()) {
+                // Closed goal is better than anything left in open list
+                if (_best != std::size_t(-1) && _open.f(_open.top()) >= _nodes[_best].g)
+                    break;
+
+                if (exhausted()) {
+                    _statistics.exhausted = true;
+                    break;
+                }
 
-            while (_open.size() > 0) {
-                _closed.push_back(_open.front());
-                _open.erase(_open.begin());
-                const std::size_t currentId = _closed.back();
-                const Node *current = &_nodes[currentId];
+                const std::size_t currentId = _open.pop();
+                ++_statistics.expanded;
+                _nodes[currentId].closed = _iteration;
+
+                // Expanded state is kept aside since storage grows while expanding
+                if (_nodeStorage == NodeStorage::Delta)
+                    materialize(currentId, _current);
+                else
+                    _current = _states[currentId];
+
+                _currentId = currentId;
 
 #if defined(_DEBUG)
-                dump(current);
+                dump(&_nodes[currentId]);
 #endif
 
                 // Check if current state meets goal state
-                if (current->state.meets(initial)) {
-                    std::vector<ActionBind> result;
-                    const Node *node = current;
+                if (_current.meets(_initial)) {
+                    if (std::find(_goals.begin(), _goals.end(), currentId) == _goals.end())
+                        _goals.push_back(currentId);
 
-                    do {
-                        result.push_back(node->action);
-                        node = &_nodes[node->parent];
-                    } while (node->parent != std::size_t(-1));
+                    if (_best == std::size_t(-1) || _nodes[currentId].g < _nodes[_best].g)
+                        _best = currentId;
 
-                    return{ _values, std::move(result) };
+                    break;
                 }
 
-                const auto &actions = _domain.actions();
-
-                // Iterate through all actions
-                for (std::size_t i = 0; i < actions.size(); ++i) {
-                    const Action &action = actions[i];
+                if ((*_domain).batched()) {
+                    // Unknown facts of all successors are evaluated
+                    // together, then successors are generated in order
                     std::size_t count{ 0 };
 
-                    _binds.clear();
-                    _ranges.clear();
-                    _indices.clear();
-
-                    // First let's see if we can connect to current state with this action
-                    // This means that at least one effect can lead to this state
-                    for (const auto &effect : action.effects) {
-                        const auto binds = current->state.range(effect.index);
-                        const std::size_t start{ _binds.size() };
-                        Range range{ start, start };
-
-                        if (binds.first == current->state._tokenMap.end()) {
-                            _binds.push_back({ static_cast<std::uint8_t>(effect.index) });
-                            ++range.max;
-                        } else {
-                            for (auto it = binds.first; it != binds.second; ++it) {
-                                if (current->state.get((*it).second) == effect.state) {
-                                    _binds.push_back((*it).second);
-                                    ++range.max;
-                                    ++count;
-                                }
-                            }
-                        }
-
-                        _ranges.push_back(range);
-                        _indices.push_back(start);
+                    expand(_current, successor, [&](State &outcome, const ActionBind &actionBind, const CompiledAction &action) {
+                        collect(outcome, _initial);
+
+                        // Default states allocate from heap, so buffer outlives arena
+                        if (count == _successors.size())
+                            _successors.emplace_back();
+
+                        Successor &next = _successors[count++];
+                        next.state = outcome;
+                        next.action = actionBind;
+                        next.cost = action.cost;
+                    });
+
+                    flush(_initial);
+
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const Successor &next = _successors[i];
+                        successor = next.state;
+                        generate(successor, next.action, _nodes[currentId].g + next.cost);
                     }
+                } else {
+                    expand(_current, successor, [&](State &outcome, const ActionBind &actionBind, const CompiledAction &action) {
+                        updateState(outcome, _initial);
+                        generate(outcome, actionBind, _nodes[currentId].g + action.cost);
+                    });
+                }
+            }
 
-                    if (count == 0)
-                        continue;
+            _statistics.evaluations = _heuristic.evaluations();
+            GOAP_PROFILE(_profile.peakNodeBytes = std::max(_profile.peakNodeBytes, memory()));
+
+            return !_statistics.exhausted;
+        }
+
+        void Planner::generate(State &outcome, const ActionBind &actionBind, double cost)
+        {
+            const std::size_t existing = find(outcome);
+
+            if (existing == std::size_t(-1)) {
+                const double h = estimate(outcome);
+                const std::size_t index = _nodes.size();
+                _nodes.push_back({
+                    cost,
+                    h,
+                    actionBind,
+                    _currentId,
+                    outcome.hash()
+                });
+                insert(index);
+                store(_nodes.back(), _current, outcome);
+
+                // No action can achieve some fact of outcome, node is
+                // parked outside open list until replan revives it
+                if (h == std::numeric_limits<double>::infinity())
+                    return;
+
+                ++_statistics.generated;
+                _open.push(index, cost, _weight * h);
+            } else {
+                Node &node = _nodes[existing];
+                const bool open = _open.contains(existing);
+                const bool parked = parkedNode(existing);
+                GOAP_PROFILE(++(open ? _profile.openHits : _profile.closedHits));
+
+                // Skip nodes with better path, closed nodes
+                // are only repaired by weighted search
+                if (cost >= node.g || (!open && !parked && _limits.weight <= 1.0))
+                    return;
+
+                // Same state has the same estimate
+                node.g = cost;
+                node.action = actionBind;
+                node.parent = _currentId;
+
+                if (open) {
+                    _open.update(existing, node.g, _weight * node.h);
+                } else if (parked) {
+                    // Cheaper path is kept for when it is revived
+                } else if (node.closed == _iteration) {
+                    // Expanded once per iteration, kept for the next one
+                    if (!node.inconsistent) {
+                        node.inconsistent = true;
+                        _incons.push_back(existing);
+                    }
+                } else
+                    _open.push(existing, node.g, _weight * node.h);
+
+                // Delta is relative to parent, so it must follow new parent
+                if (_nodeStorage == NodeStorage::Delta)
+                    store(node, _current, outcome);
+            }
+        }
+
+        void Planner::tighten()
+        {
+            _weight = _limits.step > 0.0 ? std::max(1.0, _weight - _limits.step) : 1.0;
+            ++_iteration;
+
+            // Open list is ordered by new weight
+            for (std::size_t id = 0; id < _nodes.size(); ++id) {
+                if (_open.contains(id))
+                    _open.update(id, _nodes[id].g, _weight * _nodes[id].h);
+            }
+
+            for (const auto id : _incons) {
+                _nodes[id].inconsistent = false;
+                _open.push(id, _nodes[id].g, _weight * _nodes[id].h);
+            }
+
+            _incons.clear();
+        }
 
-                    do {
-                        State outcome{ current->state };
-                        ActionBind actionBind{ static_cast<std::uint8_t>(i) };
-
-                        // Bind slots for action and fill state
-                        if (!bindSlots(action, actionBind, outcome))
-                            continue;
-
-                        updateState(outcome, initial);
-
-                        auto nodeEqual = [this, &outcome](std::size_t i) {
-                            return _nodes[i].state == outcome;
-                        };
-
-                        auto nodeLess = [this](std::size_t l, std::size_t r) {
-                            return _nodes[l] < _nodes[r];
-                        };
-
-                        auto it = std::find_if(_closed.begin(), _closed.end(), nodeEqual);
-
-                        if (it != _closed.end())
-                            continue;
-
-                        it = std::find_if(_open.begin(), _open.end(), nodeEqual);
-
-                        if (it == _open.end()) {
-                            const std::size_t index = _nodes.size();
-                            _nodes.push_back({
-                                outcome,
-                                current->g + action.cost,
-                                initial - outcome, 
-                                actionBind,
-                                currentId
-                            });
-                            const auto it = std::lower_bound(_open.begin(), _open.end(), index, nodeLess);
-                            _open.emplace(it, index);
-                            current = &_nodes[currentId];
-                        } else {
-                            Node &node = _nodes[*it];
-                            node.g = current->g + action.cost;
-                            node.h = initial - outcome;
-                            node.action = actionBind;
-                            node.parent = currentId;
-                            std::sort(_open.begin(), _open.end(), nodeLess);
-                            current = &_nodes[currentId];
-                        }
-                    } while (next());
+        bool Planner::finish(Plan &result)
+        {
+            GOAP_PROFILE(TraceScope trace{ _trace, "finish" });
+
+            if (_best == std::size_t(-1))
+                return false;
+
+            const Node *node = &_nodes[_best];
+
+            while (node->parent != std::size_t(-1)) {
+                result.actions.push_back(node->action);
+                node = &_nodes[node->parent];
+            }
+
+            result.values.assign(_values.begin(), _values.end());
+
+            // Complete search without weight is optimal, otherwise cheapest
+            // open or inconsistent node bounds cost of optimal plan
+            const double cost{ _nodes[_best].g };
+            double lower{ cost };
+
+            if (_statistics.exhausted || _weight > 1.0) {
+                for (std::size_t id = 0; id < _nodes.size(); ++id) {
+                    if (_open.contains(id) || _nodes[id].inconsistent)
+                        lower = std::min(lower, _nodes[id].f());
                 }
             }
 
-            return{};
+            _statistics.cost = cost;
+            _statistics.bound = lower < cost ? cost / lower : 1.0;
+
+            return true;
+        }
+
+        void Planner::refresh()
+        {
+            if (_source != nullptr && (*_domain).version() != (*_source).version())
+                _domain = (*_source).compile();
+
+            if (_predicateCache != nullptr)
+                _predicateCache->setEpoch((*_domain).epoch());
+        }
+
+        void Planner::reset()
+        {
+            // Drop everything allocated from arena before rewinding it
+            _nodes.clear();
+            _states.clear();
+            _arena.reset();
+
+            _deltaBinds.clear();
+            _deltaValues.clear();
+            _cacheNext = 0;
+            _currentId = std::size_t(-1);
+            _goals.clear();
+            _incons.clear();
+            _best = std::size_t(-1);
+            _weight = std::max(1.0, _limits.weight);
+            _iteration = 1;
+
+            for (auto &entry : _cache)
+                entry.id = std::size_t(-1);
+
+            std::fill(_index.begin(), _index.end(), std::size_t(-1));
+
+            if (_openListType == OpenListType::Bucket && (!(*_domain).integralCosts() || _weight != 1.0))
+                _open.setType(OpenListType::BinaryHeap);
+            else
+                _open.setType(_openListType);
+        }
+
+        void Planner::prepare(const Goal &g, State &initial, State &goal)
+        {
+            GOAP_PROFILE(TraceScope trace{ _trace, "prepare" });
+
+            // First create goal state and
+            // calculate initial state
+            for (const auto &c : g.conditions)
+                goal.set(from(c), c.state);
+
+            if ((*_domain).batched()) {
+                collect(goal, initial);
+                flush(initial);
+            } else
+                updateState(goal, initial);
         }
 
         void Planner::dump(const Node *current)
@@ -179,12 +579,13 @@ namespace ai
             const Node *node = current;
 
             while (node->parent != std::size_t(-1)) {
-                const Action &action = _domain.action(node->action.id);
-                std::cout << action.name << "(";
+                const CompiledAction &action = (*_domain).action(node->action.id());
+                std::cout << (*_domain).actionName(node->action.id()) << "(";
 
                 for (std::size_t i = 0; i < action.args; ++i) {
-                    const std::size_t index = node->action.slots[i];
-                    std::cout << _values[index].value << ", ";
+                    const std::size_t index = node->action.slot(i);
+                    print((*_domain).symbols(), _values[index]);
+                    std::cout << ", ";
                 }
 
                 std::cout << ") -> ";
@@ -194,6 +595,189 @@ namespace ai
             std::cout << std::endl;
         }
 
+        bool Planner::evaluate(const PredicateBind &bind)
+        {
+            return evaluate(_values, bind);
+        }
+
+        bool Planner::evaluate(const std::vector<Value> &values, const PredicateBind &bind)
+        {
+            const CompiledPredicate &predicate = (*_domain).predicate(bind.id());
+            GOAP_PROFILE(const auto begin = std::chrono::steady_clock::now());
+
+            const bool result = _predicateCache != nullptr
+                ? _predicateCache->evaluate(predicate, _agent, values, bind)
+                : predicate(_agent, values, bind);
+
+            GOAP_PROFILE(record(_profile.predicates, bind.id(), begin));
+            return result;
+        }
+
+        std::uint64_t Planner::evaluate(const PredicateBind *binds, std::size_t count)
+        {
+            const CompiledPredicate &predicate = (*_domain).predicate(binds[0].id());
+            GOAP_PROFILE(const auto begin = std::chrono::steady_clock::now());
+
+            const std::uint64_t result = _predicateCache != nullptr
+                ? _predicateCache->evaluate(predicate, _agent, _values, binds, count)
+                : predicate(_agent, _values, binds, count);
+
+            GOAP_PROFILE(record(_profile.predicates, binds[0].id(), begin));
+            return result;
+        }
+
+        double Planner::estimate(const State &state)
+        {
+            GOAP_PROFILE(const auto begin = std::chrono::steady_clock::now());
+            const double h = _heuristic(state, _initial);
+            GOAP_PROFILE(_profile.heuristic += std::chrono::steady_clock::now() - begin);
+            return h;
+        }
+
+        std::size_t Planner::memory() const
+        {
+            return _nodes.capacity() * sizeof(Node)
+                + _states.capacity() * sizeof(State)
+                + _deltaBinds.capacity() * sizeof(PredicateBind)
+                + _deltaValues.capacity() / 8
+                + _index.capacity() * sizeof(std::size_t)
+                + _arena.used();
+        }
+
+        bool Planner::parkedNode(const std::size_t id) const
+        {
+            return _nodes[id].h == std::numeric_limits<double>::infinity() && _nodes[id].closed == 0 && !_open.contains(id);
+        }
+
+        std::size_t Planner::find(const State &state)
+        {
+            if (_index.empty())
+                return std::size_t(-1);
+
+            const std::uint64_t hash = state.hash();
+            const std::size_t mask = _index.size() - 1;
+
+            // Full comparison only on fingerprint collision
+            for (std::size_t i = hash & mask; _index[i] != std::size_t(-1); i = (i + 1) & mask) {
+                const std::size_t id = _index[i];
+
+                if (_nodes[id].hash == hash && this->state(id) == state)
+                    return id;
+            }
+
+            return std::size_t(-1);
+        }
+
+        void Planner::insert(const std::size_t id)
+        {
+            // Keep load factor at most one half
+            if (_nodes.size() * 2 > _index.size()) {
+                const std::size_t size = std::max<std::size_t>(64, _index.size() * 2);
+                _index.assign(size, std::size_t(-1));
+
+                for (std::size_t i = 0; i < _nodes.size(); ++i) {
+                    if (i != id)
+                        insert(i);
+                }
+            }
+
+            const std::size_t mask = _index.size() - 1;
+            std::size_t i = _nodes[id].hash & mask;
+
+            while (_index[i] != std::size_t(-1))
+                i = (i + 1) & mask;
+
+            _index[i] = id;
+        }
+
+        const State &Planner::state(const std::size_t id)
+        {
+            if (id == _currentId)
+                return _current;
+
+            if (_nodeStorage == NodeStorage::Full)
+                return _states[id];
+
+            // Valid only until next call
+            materialize(id, _scratch);
+            return _scratch;
+        }
+
+        void Planner::materialize(const std::size_t id, State &state)
+        {
+            constexpr std::size_t cacheSize{ 16 };
+            const State *base = nullptr;
+            std::size_t node{ id };
+
+            // Walk up until root or any cached ancestor
+            _chain.clear();
+
+            while (node != std::size_t(-1)) {
+                const auto it = std::find_if(_cache.begin(), _cache.end(), [node](const CacheEntry &entry) {
+                    return entry.id == node;
+                });
+
+                if (it != _cache.end()) {
+                    base = &(*it).state;
+                    break;
+                }
+
+                _chain.push_back(node);
+                node = _nodes[node].parent;
+            }
+
+            if (base != nullptr)
+                state = *base;
+            else
+                state = State{};
+
+            for (auto it = _chain.rbegin(); it != _chain.rend(); ++it) {
+                const Node &n = _nodes[*it];
+
+                for (std::size_t i = n.delta; i < n.delta + n.changes; ++i)
+                    state.set(_deltaBinds[i], _deltaValues[i]);
+            }
+
+            if (_chain.empty())
+                return;
+
+            // Entries are reused so their storage survives between plans
+            if (_cache.size() < cacheSize)
+                _cache.emplace_back();
+
+            CacheEntry &entry = _cache[_cacheNext];
+            _cacheNext = (_cacheNext + 1) % cacheSize;
+            entry.id = id;
+            entry.state = state;
+        }
+
+        void Planner::store(Node &node, const State &parent, State &state)
+        {
+            if (_nodeStorage == NodeStorage::Full) {
+                _states.push_back(std::move(state));
+                return;
+            }
+
+            node.delta = static_cast<std::uint32_t>(_deltaBinds.size());
+
+            // Parent facts are ordered subsequence of child facts
+            std::size_t j{ 0 };
+
+            for (std::size_t i = 0; i < state.size(); ++i) {
+                const PredicateBind bind = state.bind(i);
+
+                if (j < parent.size() && parent.bind(j) == bind) {
+                    if (parent.value(j++) == state.value(i))
+                        continue;
+                }
+
+                _deltaBinds.push_back(bind);
+                _deltaValues.push_back(state.value(i));
+            }
+
+            node.changes = static_cast<std::uint32_t>(_deltaBinds.size()) - node.delta;
+        }
+
         bool Planner::next()
         {
             std::size_t index{ 0 };
@@ -212,35 +796,36 @@ namespace ai
             return index < _ranges.size();
         }
 
-        bool Planner::bindSlots(const Action &action, ActionBind &actionBind, State &state)
+        bool Planner::bindSlots([[maybe_unused]] const std::size_t index, const CompiledAction &action, ActionBind &actionBind, State &state)
         {
             // Check if action has specialized map function
             if (action.bindFunc != nullptr) {
-                return action.bindFunc(action, _binds, _indices, _values, actionBind, state);
+                GOAP_PROFILE(const auto begin = std::chrono::steady_clock::now());
+                const bool result = action.bindFunc(*_domain, action, _binds, _indices, _values, actionBind, state);
+                GOAP_PROFILE(record(_profile.binds, index, begin));
+                return result;
             } else {
                 // TODO: revise
                 // maybe add runtime checks? debug mode
-                for (std::size_t i = 0; i < action.effects.size(); ++i) {
-                    const std::size_t index = _indices[i];
-                    const PredicateBind pred = _binds[index];
-                    const Condition &effect = action.effects[i];
-
-                    for (std::size_t i = 0; i < effect.slots.size(); ++i) {
-                        const std::size_t ai = effect.slots[i];
-                        actionBind.slots[ai] = pred.slots[i];
-                    }
+                const CompiledCondition *effects = (*_domain).effects(action);
+                const CompiledCondition *preconditions = (*_domain).preconditions(action);
+
+                for (std::size_t i = 0; i < action.effects; ++i) {
+                    const PredicateBind pred = _binds[_indices[i]];
+                    const CompiledCondition &effect = effects[i];
+
+                    for (std::size_t i = 0; i < effect.arity; ++i)
+                        actionBind.setSlot(effect.slots[i], pred.slot(i));
 
                     state.set(pred, !effect.state);
                 }
 
-                for (std::size_t i = 0; i < action.preconditions.size(); ++i) {
-                    const Condition &precondition = action.preconditions[i];
-                    PredicateBind pred{ static_cast<std::uint8_t>(precondition.index) };
+                for (std::size_t i = 0; i < action.preconditions; ++i) {
+                    const CompiledCondition &precondition = preconditions[i];
+                    PredicateBind pred{ precondition.predicate };
 
-                    for (std::size_t i = 0; i < precondition.slots.size(); ++i) {
-                        const std::size_t ai = precondition.slots[i];
-                        pred.slots[i] = actionBind.slots[ai];
-                    }
+                    for (std::size_t i = 0; i < precondition.arity; ++i)
+                        pred.setSlot(i, actionBind.slot(precondition.slots[i]));
 
                     state.set(pred, precondition.state);
                 }
@@ -253,15 +838,47 @@ namespace ai
 
         void Planner::updateState(const State &current, State &state)
         {
-            for (const auto &s : current._stateMap) {
-                auto it = state._stateMap.find(s.first);
+            for (std::size_t i = 0; i < current.size(); ++i) {
+                const PredicateBind bind = current.bind(i);
 
-                if (it == state._stateMap.end()) {
-                    const Predicate &predicate = _domain.predicate(s.first.id);
-                    const bool value = predicate(nullptr, _values, s.first);
-                    state.set(s.first, value);
-                }
+                if (!state.contains(bind))
+                    state.set(bind, evaluate(bind));
             }
         }
+
+        void Planner::collect(const State &current, const State &state)
+        {
+            for (std::size_t i = 0; i < current.size(); ++i) {
+                const PredicateBind bind = current.bind(i);
+
+                if (!state.contains(bind))
+                    _pending.push_back(bind);
+            }
+        }
+
+        void Planner::flush(State &state)
+        {
+            // Group facts by predicate, several successors share most of them
+            std::sort(_pending.begin(), _pending.end(), [](const PredicateBind &a, const PredicateBind &b) {
+                return a.id() != b.id() ? a.id() < b.id() : a.data < b.data;
+            });
+            _pending.erase(std::unique(_pending.begin(), _pending.end()), _pending.end());
+
+            for (std::size_t first = 0; first < _pending.size();) {
+                std::size_t last{ first + 1 };
+
+                while (last < _pending.size() && last - first < Predicate::BatchSize && _pending[last].id() == _pending[first].id())
+                    ++last;
+
+                const std::uint64_t values = evaluate(_pending.data() + first, last - first);
+
+                for (std::size_t i = first; i < last; ++i)
+                    state.set(_pending[i], (values >> (i - first)) & 1);
+
+                first = last;
+            }
+
+            _pending.clear();
+        }
     }
 }
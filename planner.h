@@ -4,9 +4,18 @@
 #include "state.h"
 #include "goal.h"
 #include "plan.h"
+#include "openlist.h"
+#include "arena.h"
+#include "predicatecache.h"
+#include "plancache.h"
+#include "heuristic.h"
+#include "instrumentation.h"
 
 #include <unordered_set>
 #include <array>
+#include <algorithm>
+#include <memory>
+#include <chrono>
 
 /*namespace std
 {
@@ -35,28 +44,139 @@ namespace ai
         class Domain;
         struct Goal;
 
+        enum class NodeStorage
+        {
+            Full,
+            // Nodes keep only facts changed relative to parent,
+            // full states are rebuilt on demand
+            Delta
+        };
+
+        struct SearchStatistics
+        {
+            HeuristicType heuristic;
+            std::size_t expanded;
+            std::size_t generated;
+            // Heuristic evaluations
+            std::size_t evaluations;
+            // Cost of returned plan and proven ratio to optimal cost,
+            // bound holds for admissible heuristic only
+            double cost;
+            double bound;
+            // Search stopped by limits, improve continues it
+            bool exhausted;
+        };
+
+        struct SearchLimits
+        {
+            // Expansions per call, zero is unlimited
+            std::size_t expansions = 0;
+            // Time per call, zero is unlimited
+            std::chrono::microseconds time{ 0 };
+            // Cost of first plan is at most weight times optimal cost
+            double weight = 1.0;
+            // Weight is lowered by step after each plan until it is one
+            double step = 0.5;
+        };
+
         class Planner
         {
         public:
-            Planner(const Domain &domain);
+            // Follows changes of domain, it is compiled again
+            // on next plan call once its version changes
+            Planner(const Domain &domain, OpenListType openList = OpenListType::BinaryHeap);
+            Planner(std::shared_ptr<const CompiledDomain> domain, OpenListType openList = OpenListType::BinaryHeap);
+
+            // Domain of last plan, replanning doesn't compile it again
+            const CompiledDomain &domain() const { return *_domain; }
+
+            // Bucket open list falls back to binary heap
+            // when domain has non integral action costs
+            void setOpenList(OpenListType type) { _openListType = type; }
+            OpenListType openList() const { return _openListType; }
+
+            void setNodeStorage(NodeStorage storage) { _nodeStorage = storage; }
+            NodeStorage nodeStorage() const { return _nodeStorage; }
+
+            // Can be changed between plan calls
+            void setHeuristic(HeuristicType type) { _heuristic.setType(type); }
+            void setHeuristic(HeuristicFunc func) { _heuristic.setFunc(func); }
+            HeuristicType heuristic() const { return _heuristic.type(); }
+
+            // Cache is not owned and persists between plans,
+            // caller invalidates it when world changes
+            void setPredicateCache(PredicateCache *cache) { _predicateCache = cache; }
+            PredicateCache *predicateCache() const { return _predicateCache; }
 
-            Plan plan(const Goal &goal);
+            // Cache is not owned and may be shared between planners,
+            // searches of plan are looked up in it and stored to it
+            void setPlanCache(PlanCache *cache) { _planCache = cache; }
+            PlanCache *planCache() const { return _planCache; }
+
+            Plan plan(const Goal &goal, Agent *agent = nullptr);
+            // Reuses storage of given plan, no allocations after warm-up
+            bool plan(const Goal &goal, Plan &plan, Agent *agent = nullptr);
+
+            // Continues last search after facts of initial state changed,
+            // nodes are kept and only their distance to initial state is
+            // repaired. Predicate cache must be invalidated by caller
+            bool replan(const std::vector<PredicateBind> &changed, Plan &plan, Agent *agent = nullptr);
+
+            // Weighted search with repairing of inconsistent nodes, so every
+            // plan within bound reuses work of the previous one. Plan call
+            // returns best plan found within limits, weight is applied
+            // from next plan call and bucket open list falls back to heap
+            void setLimits(const SearchLimits &limits) { _limits = limits; }
+            const SearchLimits &limits() const { return _limits; }
+
+            // Continues last plan call with fresh limits, either search
+            // stopped by limits or looking for plan with lower bound
+            bool improve(Plan &plan, Agent *agent = nullptr);
+
+            // Statistics of last plan, replan or improve call
+            const SearchStatistics &statistics() const { return _statistics; }
+
+#if GOAP_INSTRUMENTATION
+            // Profile of last plan, replan or improve call
+            const SearchProfile &profile() const { return _profile; }
+
+            // Sink is not owned, gets span of every call and its phases
+            void setTraceSink(TraceSink *sink) { _trace = sink; }
+            TraceSink *traceSink() const { return _trace; }
+#endif
+
+            // Backs all per plan states, reset on every plan call
+            Arena &arena() { return _arena; }
+            const Arena &arena() const { return _arena; }
+
+            // Bytes of nodes, states, index and arena of last search,
+            // storage is kept between plans so it only grows
+            std::size_t memory() const;
 
         private:
+            friend class ParallelPlanner;
+
             struct Node
             {
-                State state;
                 double g;
                 double h;
                 ActionBind action;
                 std::size_t parent = std::size_t(-1);
+                std::uint64_t hash = 0;
+                // Changed facts in delta storage
+                std::uint32_t delta = 0;
+                std::uint32_t changes = 0;
+                // Iteration of weighted search which expanded node
+                std::uint32_t closed = 0;
+                bool inconsistent = false;
 
                 double f() const { return g + h; }
+            };
 
-                bool operator<(const Node &other)
-                {
-                    return f() < other.f();
-                }
+            struct CacheEntry
+            {
+                std::size_t id = std::size_t(-1);
+                State state;
             };
 
             struct Range
@@ -65,22 +185,194 @@ namespace ai
                 std::size_t max;
             };
 
+            // Regressed state waiting for batch of its facts
+            struct Successor
+            {
+                State state;
+                ActionBind action;
+                double cost = 0.0;
+            };
+
         private:
+            // Calls func(outcome, actionBind, action) for every regression
+            // of state through domain actions, outcome facts are not yet
+            // evaluated against initial state
+            template<typename Func>
+            void expand(const State &state, State &outcome, Func &&func);
+
+            void refresh();
+            void reset();
+            void prepare(const Goal &g, State &initial, State &goal);
+            void start();
+            void begin();
+            bool exhausted();
+            bool anytime(Plan &result);
+            bool search();
+            void tighten();
+            bool finish(Plan &result);
             void dump(const Node *node);
             bool next();
-            bool bindSlots(const Action &action, ActionBind &actionBind, State &state);
+            bool evaluate(const PredicateBind &bind);
+            bool evaluate(const std::vector<Value> &values, const PredicateBind &bind);
+            // Binds of the same predicate, at most its batch size
+            std::uint64_t evaluate(const PredicateBind *binds, std::size_t count);
+            double estimate(const State &state);
+            std::size_t find(const State &state);
+            void insert(const std::size_t id);
+            // Dead end which was never expanded nor put in open list
+            bool parkedNode(const std::size_t id) const;
+            const State &state(const std::size_t id);
+            void materialize(const std::size_t id, State &state);
+            void store(Node &node, const State &parent, State &state);
+            bool bindSlots(const std::size_t index, const CompiledAction &action, ActionBind &actionBind, State &state);
             void updateState(const State &current, State &state);
+            // Queue facts of current missing in state, flush
+            // evaluates them in one batch per predicate
+            void collect(const State &current, const State &state);
+            void flush(State &state);
+            void generate(State &outcome, const ActionBind &actionBind, double cost);
 
         private:
-            const Domain &_domain;
+            const Domain *_source;
+            std::shared_ptr<const CompiledDomain> _domain;
+            Arena _arena;
+            OpenListType _openListType;
+            NodeStorage _nodeStorage;
+            PredicateCache *_predicateCache;
+            PlanCache *_planCache;
+            Heuristic _heuristic;
+            SearchStatistics _statistics;
+            SearchLimits _limits;
+            std::chrono::steady_clock::time_point _deadline;
+            // Weight and iteration of current search
+            double _weight;
+            std::uint32_t _iteration;
+            std::size_t _best;
+            // Closed nodes which got cheaper path in current iteration
+            std::vector<std::size_t> _incons;
+            Agent *_agent;
             std::vector<Node> _nodes;
-            std::vector<std::size_t> _open;
-            std::vector<std::size_t> _closed;
+            // Full storage
+            std::vector<State> _states;
+            // Delta storage
+            std::vector<PredicateBind> _deltaBinds;
+            std::vector<bool> _deltaValues;
+            std::vector<CacheEntry> _cache;
+            std::size_t _cacheNext;
+            std::vector<std::size_t> _chain;
+            std::size_t _currentId;
+            // Last goal and lazily evaluated initial state
+            State _initial;
+            State _goal;
+            std::vector<PredicateBind> _changed;
+            // Closed nodes meeting initial state
+            std::vector<std::size_t> _goals;
+            // Goals which stopped holding on replan
+            std::vector<std::size_t> _reopened;
+            State _current;
+            State _scratch;
+            OpenList _open;
+            // Open addressing table from state fingerprint
+            // to node id for open and closed nodes
+            std::vector<std::size_t> _index;
             std::vector<Value> _values;
             std::vector<PredicateBind> _binds;
             std::vector<Range> _ranges;
             std::vector<std::size_t> _indices;
+            std::vector<std::size_t> _candidates;
+            std::vector<bool> _visited;
+            std::vector<PredicateBind> _pending;
+            std::vector<Successor> _successors;
+#if GOAP_INSTRUMENTATION
+            SearchProfile _profile{};
+            TraceSink *_trace = nullptr;
+#endif
 
         };
+
+        template<typename Func>
+        void Planner::expand(const State &state, State &outcome, Func &&func)
+        {
+            const CompiledDomain &domain = *_domain;
+
+            // Only actions with effect matching some fact can regress state
+            _candidates.clear();
+            _visited.resize(domain.actionCount(), false);
+
+            for (std::size_t j = 0; j < state.size(); ++j) {
+                for (const auto i : domain.achievers(state.bind(j).id(), state.value(j))) {
+                    if (!_visited[i]) {
+                        _visited[i] = true;
+                        _candidates.push_back(i);
+                    }
+                }
+            }
+
+            // Keep domain order, so plan doesn't depend on index
+            std::sort(_candidates.begin(), _candidates.end());
+
+            for (const auto i : _candidates) {
+                const CompiledAction &action = domain.action(i);
+                const CompiledCondition *effects = domain.effects(action);
+                std::size_t count{ 0 };
+
+                _visited[i] = false;
+                _binds.clear();
+                _ranges.clear();
+                _indices.clear();
+
+                // First let's see if we can connect to current state with this action
+                // This means that at least one effect can lead to this state
+                for (std::size_t e = 0; e < action.effects; ++e) {
+                    const CompiledCondition &effect = effects[e];
+                    const auto binds = state.range(effect.predicate);
+                    const std::size_t start{ _binds.size() };
+                    Range range{ start, start };
+
+                    for (std::size_t j = binds.first; j < binds.second; ++j) {
+                        if (state.value(j) == effect.state) {
+                            _binds.push_back(state.bind(j));
+                            ++range.max;
+                            ++count;
+                        }
+                    }
+
+                    // Effect is not connected, leave its slots unbound
+                    if (range.max == range.min) {
+                        _binds.push_back({ effect.predicate });
+                        ++range.max;
+                    }
+
+                    _ranges.push_back(range);
+                    _indices.push_back(start);
+                }
+
+                if (count == 0)
+                    continue;
+
+                do {
+                    outcome = state;
+                    ActionBind actionBind{ i };
+                    const std::size_t values{ _values.size() };
+                    GOAP_PROFILE(++_profile.combinations);
+
+                    // Bind slots for action and fill state, values
+                    // added by rejecting bind function are dropped
+                    if (!bindSlots(i, action, actionBind, outcome)) {
+                        GOAP_PROFILE(++_profile.bindRejections);
+                        _values.resize(values);
+                        continue;
+                    }
+
+                    // Values added by bind function don't fit slots
+                    if (_values.size() > PredicateBind::MaxValues) {
+                        _values.resize(values);
+                        continue;
+                    }
+
+                    func(outcome, actionBind, action);
+                } while (next());
+            }
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include "planningservice.h"
+
+#include <algorithm>
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            std::chrono::microseconds since(const std::chrono::steady_clock::time_point time)
+            {
+                return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - time);
+            }
+        }
+
+        bool PlanningService::Handle::ready() const
+        {
+            return _future.valid() && _future.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+        }
+
+        PlanningService::PlanningService(const Domain &domain, std::size_t threads) :
+            _capacity{ 0 },
+            _slice{ 256 },
+            _sequence{ 0 },
+            _stop{ false },
+            _statistics{}
+        {
+            threads = std::max<std::size_t>(threads, 1);
+
+            for (std::size_t i = 0; i < threads; ++i)
+                _workers.push_back(std::make_unique<Worker>(domain));
+
+            // Started once all planners exist, workers never touch other planners
+            for (std::size_t i = 0; i < threads; ++i)
+                (*_workers[i]).thread = std::thread{ &PlanningService::run, this, i };
+        }
+
+        PlanningService::~PlanningService()
+        {
+            std::vector<std::shared_ptr<Job>> pending;
+
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                _stop = true;
+
+                for (const auto &job : _queue)
+                    drop(job, RequestStatus::Cancelled);
+
+                pending.assign(_queue.begin(), _queue.end());
+                _queue.clear();
+
+                for (auto &worker : _workers) {
+                    if ((*worker).job != nullptr)
+                        (*(*worker).job).cancelled = true;
+                }
+            }
+
+            _wake.notify_all();
+
+            for (const auto &job : pending)
+                complete(*job, { RequestStatus::Cancelled, {}, since((*job).submitted), {} });
+
+            for (auto &worker : _workers) {
+                if ((*worker).thread.joinable())
+                    (*worker).thread.join();
+            }
+        }
+
+        PlanningService::Handle PlanningService::submit(const ServiceRequest &request)
+        {
+            auto job = std::make_shared<Job>();
+            (*job).goal = *request.goal;
+            (*job).agent = request.agent;
+            (*job).priority = request.priority;
+            (*job).deadline = request.deadline;
+            (*job).callback = request.callback;
+            (*job).submitted = std::chrono::steady_clock::now();
+
+            Handle handle;
+            handle._job = job;
+            handle._future = (*job).promise.get_future().share();
+
+            // Superseded and rejected requests are completed out of lock
+            std::shared_ptr<Job> superseded;
+            std::shared_ptr<Job> rejected;
+
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                (*job).sequence = _sequence++;
+                ++_statistics.submitted;
+
+                if (request.agent != nullptr) {
+                    auto latest = _latest.find(request.agent);
+
+                    if (latest != _latest.end()) {
+                        superseded = (*latest).second;
+
+                        if (_queue.erase(superseded) != 0)
+                            drop(superseded, RequestStatus::Cancelled);
+                        else {
+                            // Running one stops after its slice
+                            (*superseded).cancelled = true;
+                            superseded = nullptr;
+                        }
+                    }
+                }
+
+                if (_stop)
+                    rejected = job;
+                else if (_capacity != 0 && _queue.size() >= _capacity) {
+                    const auto lowest = std::prev(_queue.end());
+                    rejected = Order{}(job, *lowest) ? *lowest : job;
+
+                    if (rejected != job)
+                        _queue.erase(lowest);
+                }
+
+                if (rejected != nullptr)
+                    drop(rejected, RequestStatus::Rejected);
+
+                if (rejected != job) {
+                    _queue.insert(job);
+                    _statistics.peakDepth = std::max(_statistics.peakDepth, _queue.size());
+
+                    if (request.agent != nullptr)
+                        _latest[request.agent] = job;
+                }
+            }
+
+            if (superseded != nullptr)
+                complete(*superseded, { RequestStatus::Cancelled, {}, since((*superseded).submitted), {} });
+
+            if (rejected != nullptr)
+                complete(*rejected, { RequestStatus::Rejected, {}, since((*rejected).submitted), {} });
+
+            if (rejected != job)
+                _wake.notify_one();
+
+            return handle;
+        }
+
+        bool PlanningService::cancel(const Handle &handle)
+        {
+            if (!handle.valid())
+                return false;
+
+            const std::shared_ptr<Job> &job = handle._job;
+
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+
+                if ((*job).done)
+                    return false;
+
+                if (_queue.erase(job) == 0) {
+                    (*job).cancelled = true;
+                    return true;
+                }
+
+                drop(job, RequestStatus::Cancelled);
+            }
+
+            complete(*job, { RequestStatus::Cancelled, {}, since((*job).submitted), {} });
+            return true;
+        }
+
+        void PlanningService::setCapacity(std::size_t capacity)
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            _capacity = capacity;
+        }
+
+        std::size_t PlanningService::capacity() const
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            return _capacity;
+        }
+
+        ServiceStatistics PlanningService::statistics() const
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            ServiceStatistics result{ _statistics };
+            result.depth = _queue.size();
+            return result;
+        }
+
+        void PlanningService::run(const std::size_t worker)
+        {
+            Worker &self = *_workers[worker];
+
+            while (true) {
+                std::chrono::microseconds wait;
+
+                {
+                    std::unique_lock<std::mutex> lock{ _mutex };
+                    _wake.wait(lock, [this] { return _stop || !_queue.empty(); });
+
+                    if (_stop)
+                        return;
+
+                    self.job = *_queue.begin();
+                    _queue.erase(_queue.begin());
+
+                    wait = since((*self.job).submitted);
+                    ++_statistics.running;
+                    _statistics.wait += wait;
+                    _statistics.maxWait = std::max(_statistics.maxWait, wait);
+                }
+
+                Job &job = *self.job;
+                PlanResult result{ RequestStatus::Failed, {}, wait, {} };
+                serve(self, job, result);
+
+                {
+                    std::lock_guard<std::mutex> lock{ _mutex };
+                    --_statistics.running;
+                    _statistics.service += result.service;
+                    _statistics.maxService = std::max(_statistics.maxService, result.service);
+                    drop(self.job, result.status);
+                }
+
+                complete(job, std::move(result));
+
+                std::lock_guard<std::mutex> lock{ _mutex };
+                self.job = nullptr;
+            }
+        }
+
+        void PlanningService::serve(Worker &worker, Job &job, PlanResult &result)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const bool timed{ job.deadline != std::chrono::steady_clock::time_point{} };
+            bool first{ true };
+
+            // Weight of worker planner is kept, budget is given per slice
+            SearchLimits limits{ worker.planner.limits() };
+            limits.expansions = _slice;
+
+            while (true) {
+                if (job.cancelled) {
+                    result.status = RequestStatus::Cancelled;
+                    result.plan.values.clear();
+                    result.plan.actions.clear();
+                    break;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+
+                // Plan found with weight is kept
+                if (timed && now >= job.deadline) {
+                    result.status = RequestStatus::Expired;
+                    break;
+                }
+
+                limits.time = timed ? std::max(std::chrono::duration_cast<std::chrono::microseconds>(job.deadline - now), std::chrono::microseconds{ 1 }) : std::chrono::microseconds{ 0 };
+                worker.planner.setLimits(limits);
+
+                const bool found = first ? worker.planner.plan(job.goal, result.plan, job.agent) : worker.planner.improve(result.plan, job.agent);
+                first = false;
+
+                if (!worker.planner.statistics().exhausted) {
+                    result.status = found ? RequestStatus::Found : RequestStatus::Failed;
+                    break;
+                }
+            }
+
+            result.service = since(start);
+        }
+
+        void PlanningService::drop(const std::shared_ptr<Job> &job, RequestStatus status)
+        {
+            (*job).done = true;
+
+            switch (status) {
+            case RequestStatus::Found:
+                ++_statistics.found;
+                break;
+            case RequestStatus::Failed:
+                ++_statistics.failed;
+                break;
+            case RequestStatus::Cancelled:
+                ++_statistics.cancelled;
+                break;
+            case RequestStatus::Rejected:
+                ++_statistics.rejected;
+                break;
+            case RequestStatus::Expired:
+                ++_statistics.expired;
+                break;
+            }
+
+            if ((*job).agent != nullptr) {
+                auto latest = _latest.find((*job).agent);
+
+                if (latest != _latest.end() && (*latest).second == job)
+                    _latest.erase(latest);
+            }
+        }
+
+        void PlanningService::complete(Job &job, PlanResult &&result)
+        {
+            if (job.callback != nullptr)
+                job.callback(job.agent, result);
+
+            job.promise.set_value(std::move(result));
+        }
+    }
+}
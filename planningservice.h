@@ -0,0 +1,195 @@
+#pragma once
+
+#include "planner.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ai
+{
+    namespace goap
+    {
+        enum class RequestStatus
+        {
+            Found,
+            Failed,
+            // Cancelled by caller or superseded by newer request of agent
+            Cancelled,
+            // Queue was full and request didn't outrank anything in it
+            Rejected,
+            // Deadline passed before search was done, plan
+            // holds best one found so far by weighted search
+            Expired
+        };
+
+        struct PlanResult
+        {
+            RequestStatus status;
+            Plan plan;
+            // Time spent in queue and time spent planning
+            std::chrono::microseconds wait;
+            std::chrono::microseconds service;
+        };
+
+        // Called once result is ready and before future is set, on worker
+        // thread or on thread which cancelled, superseded or rejected request
+        using PlanCallback = void(*)(Agent *, const PlanResult &);
+
+        struct ServiceRequest
+        {
+            const Goal *goal;
+            Agent *agent = nullptr;
+            // Higher priority is served first, equal ones in submission order
+            int priority = 0;
+            // Zero is no deadline
+            std::chrono::steady_clock::time_point deadline{};
+            PlanCallback callback = nullptr;
+        };
+
+        struct ServiceStatistics
+        {
+            // Requests waiting in queue now and at most
+            std::size_t depth;
+            std::size_t peakDepth;
+            std::size_t running;
+            std::size_t submitted;
+            std::size_t found;
+            std::size_t failed;
+            std::size_t cancelled;
+            std::size_t rejected;
+            std::size_t expired;
+            // Totals over started requests, divide by their count for mean
+            std::chrono::microseconds wait;
+            std::chrono::microseconds service;
+            std::chrono::microseconds maxWait;
+            std::chrono::microseconds maxService;
+        };
+
+        // Plans requests of many threads on pool of workers, each owning
+        // a planner. Searches run in slices of expansions, so running
+        // request can be cancelled or stopped at its deadline. Newer
+        // request of agent supersedes its pending one. Predicates and
+        // bind functions must be thread safe
+        class PlanningService
+        {
+        private:
+            struct Job;
+
+        public:
+            class Handle
+            {
+            public:
+                Handle() = default;
+
+                bool valid() const { return _job != nullptr; }
+                bool ready() const;
+                void wait() const { _future.wait(); }
+                // Result stays in handle, copies of it share it
+                const PlanResult &get() const { return _future.get(); }
+                const std::shared_future<PlanResult> &future() const { return _future; }
+
+            private:
+                friend class PlanningService;
+
+                std::shared_ptr<Job> _job;
+                std::shared_future<PlanResult> _future;
+            };
+
+        public:
+            PlanningService(const Domain &domain, std::size_t threads = std::thread::hardware_concurrency());
+            PlanningService(const PlanningService &) = delete;
+            PlanningService &operator=(const PlanningService &) = delete;
+            // Pending requests are cancelled, running ones after their slice
+            ~PlanningService();
+
+            // Goal is copied, result of request is given by handle
+            Handle submit(const ServiceRequest &request);
+
+            // Returns false if request has already finished
+            bool cancel(const Handle &handle);
+
+            // Full queue rejects request unless it outranks the lowest
+            // queued one, which is rejected instead. Zero is unlimited
+            void setCapacity(std::size_t capacity);
+            std::size_t capacity() const;
+
+            // Expansions between checks of cancellation and deadline
+            void setSlice(std::size_t expansions) { _slice = expansions; }
+            std::size_t slice() const { return _slice; }
+
+            ServiceStatistics statistics() const;
+
+            std::size_t threads() const { return _workers.size(); }
+            // Configure heuristic and caches before submitting
+            Planner &planner(const std::size_t worker) { return (*_workers[worker]).planner; }
+
+        private:
+            struct Job
+            {
+                Goal goal;
+                Agent *agent;
+                int priority;
+                std::chrono::steady_clock::time_point deadline;
+                PlanCallback callback;
+                std::uint64_t sequence;
+                std::chrono::steady_clock::time_point submitted;
+                std::promise<PlanResult> promise;
+                std::atomic<bool> cancelled{ false };
+                bool done = false;
+            };
+
+            struct Order
+            {
+                bool operator()(const std::shared_ptr<Job> &a, const std::shared_ptr<Job> &b) const
+                {
+                    if ((*a).priority != (*b).priority)
+                        return (*a).priority > (*b).priority;
+
+                    return (*a).sequence < (*b).sequence;
+                }
+            };
+
+            struct Worker
+            {
+                Worker(const Domain &domain) :
+                    planner{ domain }
+                {
+                }
+
+                Planner planner;
+                // Request being served, guarded by mutex
+                std::shared_ptr<Job> job;
+                std::thread thread;
+            };
+
+        private:
+            void run(const std::size_t worker);
+            void serve(Worker &worker, Job &job, PlanResult &result);
+            // Marks request done and counts it, called under lock
+            void drop(const std::shared_ptr<Job> &job, RequestStatus status);
+            static void complete(Job &job, PlanResult &&result);
+
+        private:
+            std::vector<std::unique_ptr<Worker>> _workers;
+            mutable std::mutex _mutex;
+            std::condition_variable _wake;
+            std::set<std::shared_ptr<Job>, Order> _queue;
+            // Latest unfinished request of every agent
+            std::unordered_map<Agent *, std::shared_ptr<Job>> _latest;
+            std::size_t _capacity;
+            std::atomic<std::size_t> _slice;
+            std::uint64_t _sequence;
+            bool _stop;
+            ServiceStatistics _statistics;
+
+        };
+    }
+}
@@ -0,0 +1,74 @@
+#include "planningtask.h"
+#include "domain.h"
+
+#include <algorithm>
+
+namespace ai
+{
+    namespace goap
+    {
+        PlanningTask::PlanningTask(const Domain &domain, const Goal &goal, Agent *agent) :
+            _planner{ domain },
+            _goal{ goal },
+            _agent{ agent },
+            _status{ TaskStatus::InProgress },
+            _found{ false },
+            _steps{ 0 },
+            _expanded{ 0 }
+        {
+        }
+
+        PlanningTask::PlanningTask(std::shared_ptr<const CompiledDomain> domain, const Goal &goal, Agent *agent) :
+            _planner{ std::move(domain) },
+            _goal{ goal },
+            _agent{ agent },
+            _status{ TaskStatus::InProgress },
+            _found{ false },
+            _steps{ 0 },
+            _expanded{ 0 }
+        {
+        }
+
+        TaskStatus PlanningTask::step(std::size_t expansions)
+        {
+            SearchLimits limits{ _limits };
+            limits.expansions = expansions;
+            limits.time = std::chrono::microseconds{ 0 };
+            return run(limits);
+        }
+
+        TaskStatus PlanningTask::step(std::chrono::steady_clock::time_point until)
+        {
+            // Zero time is unlimited, passed deadline gets the shortest one
+            const auto left = std::chrono::duration_cast<std::chrono::microseconds>(until - std::chrono::steady_clock::now());
+
+            SearchLimits limits{ _limits };
+            limits.expansions = 0;
+            limits.time = std::max(left, std::chrono::microseconds{ 1 });
+            return run(limits);
+        }
+
+        TaskStatus PlanningTask::run(const SearchLimits &limits)
+        {
+            if (_status != TaskStatus::InProgress)
+                return _status;
+
+            _planner.setLimits(limits);
+
+            // Plan of last step is kept as it is never
+            // worse than plan of the previous one
+            if (_steps++ == 0)
+                _found = _planner.plan(_goal, _plan, _agent);
+            else
+                _found = _planner.improve(_plan, _agent);
+
+            const SearchStatistics &statistics = _planner.statistics();
+            _expanded += statistics.expanded;
+
+            if (!statistics.exhausted)
+                _status = _found ? TaskStatus::Found : TaskStatus::Failed;
+
+            return _status;
+        }
+    }
+}
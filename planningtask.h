@@ -0,0 +1,74 @@
+#pragma once
+
+#include "planner.h"
+
+#include <chrono>
+#include <memory>
+
+namespace ai
+{
+    namespace goap
+    {
+        enum class TaskStatus
+        {
+            InProgress,
+            Found,
+            Failed
+        };
+
+        // Search spread over many steps, for example one per frame. Task
+        // owns planner with its open and closed nodes, so no work is lost
+        // between steps and many tasks may be stepped on one thread.
+        // Domain snapshot of first step is used until search is done
+        class PlanningTask
+        {
+        public:
+            PlanningTask(const Domain &domain, const Goal &goal, Agent *agent = nullptr);
+            PlanningTask(std::shared_ptr<const CompiledDomain> domain, const Goal &goal, Agent *agent = nullptr);
+
+            // Weight and step of limits are applied, budget
+            // of each step is given to step call instead
+            void setLimits(const SearchLimits &limits) { _limits = limits; }
+            const SearchLimits &limits() const { return _limits; }
+
+            // Search at most given number of expansions, zero is unlimited
+            TaskStatus step(std::size_t expansions);
+            // Search until given time, clock is read every few expansions
+            // so step may overrun it by some of them
+            TaskStatus step(std::chrono::steady_clock::time_point until);
+
+            TaskStatus status() const { return _status; }
+
+            // Best plan found so far, with weight it may be
+            // available while task is still in progress
+            const Plan &plan() const { return _plan; }
+            bool found() const { return _found; }
+
+            // Number of steps made and expansions over all of them
+            std::size_t steps() const { return _steps; }
+            std::size_t expanded() const { return _expanded; }
+
+            const Goal &goal() const { return _goal; }
+            Agent *agent() const { return _agent; }
+
+            // Heuristic, caches and node storage can be set before first step
+            Planner &planner() { return _planner; }
+            const Planner &planner() const { return _planner; }
+
+        private:
+            TaskStatus run(const SearchLimits &limits);
+
+        private:
+            Planner _planner;
+            Goal _goal;
+            Agent *_agent;
+            SearchLimits _limits;
+            Plan _plan;
+            TaskStatus _status;
+            bool _found;
+            std::size_t _steps;
+            std::size_t _expanded;
+
+        };
+    }
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "value.h"
+#include "bind.h"
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 namespace ai
 {
@@ -11,55 +13,26 @@ namespace ai
     {
         class Agent;
 
-        union PredicateBind
-        {
-            struct
-            {
-                std::uint8_t id;
-                std::uint8_t slots[7];
-            };
-            std::uint64_t data;
-
-            PredicateBind() :
-                data{ std::size_t(-1) }
-            {
-            }
-
-            PredicateBind(const std::uint8_t pid) :
-                data{ std::size_t(-1) }
-            {
-                id = pid;
-            }
+        struct PredicateTag;
 
-            bool operator==(const PredicateBind &other) const
-            {
-                return data == other.data;
-            }
-        };
+        // Predicate id with indices of values in its slots
+        using PredicateBind = BasicBind<GOAP_PREDICATE_BITS, GOAP_VALUE_BITS, PredicateTag>;
 
         using PredicateFunc = bool(*)(Agent *, const std::vector<Value> &, const PredicateBind &);
 
+        // Evaluates count binds of the same predicate at once, count is
+        // at most Predicate::BatchSize. Bit i of result is value of bind i
+        using PredicateBatchFunc = std::uint64_t(*)(Agent *, const std::vector<Value> &, const PredicateBind *, std::size_t);
+
+        // Either function is set, see CompiledPredicate
         struct Predicate
         {
+            static constexpr std::size_t BatchSize = 64;
+
             std::string name;
             std::vector<std::size_t> types;
             PredicateFunc func;
-
-            bool operator()(Agent *a, const std::vector<Value> &v, const PredicateBind &p) const
-            {
-                return func(a, v, p);
-            }
+            PredicateBatchFunc batch;
         };
     }
 }
-
-namespace std
-{
-    template<> struct hash<ai::goap::PredicateBind>
-    {
-        std::size_t operator()(ai::goap::PredicateBind const &token) const noexcept
-        {
-            return std::hash<std::uint64_t>{}(token.data);
-        }
-    };
-}
@@ -0,0 +1,205 @@
+#include "predicatecache.h"
+
+namespace ai
+{
+    namespace goap
+    {
+        namespace
+        {
+            const std::size_t unbound{ PredicateBind::Unbound };
+
+            std::uint64_t combine(std::uint64_t seed, std::uint64_t value)
+            {
+                return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+            }
+        }
+
+        PredicateCache::PredicateCache() :
+            _version{ 0 },
+            _worldVersion{ 0 },
+            _epoch{ 0 },
+            _hits{ 0 },
+            _misses{ 0 },
+            _callbackTime{ 0 }
+        {
+        }
+
+        bool PredicateCache::evaluate(
+            const CompiledPredicate &predicate,
+            Agent *agent,
+            const std::vector<Value> &values,
+            const PredicateBind &bind
+        )
+        {
+            const std::size_t arity = predicate.arity;
+            bool value;
+
+            if (find(values, bind, arity, value))
+                return value;
+
+            const auto begin = std::chrono::steady_clock::now();
+            value = predicate(agent, values, bind);
+            _callbackTime += std::chrono::steady_clock::now() - begin;
+
+            store(values, bind, arity, value);
+            return value;
+        }
+
+        std::uint64_t PredicateCache::evaluate(
+            const CompiledPredicate &predicate,
+            Agent *agent,
+            const std::vector<Value> &values,
+            const PredicateBind *binds,
+            std::size_t count
+        )
+        {
+            const std::size_t arity = predicate.arity;
+            PredicateBind missing[Predicate::BatchSize];
+            std::size_t positions[Predicate::BatchSize];
+            std::size_t misses{ 0 };
+            std::uint64_t result{ 0 };
+
+            for (std::size_t i = 0; i < count; ++i) {
+                bool value;
+
+                if (!find(values, binds[i], arity, value)) {
+                    missing[misses] = binds[i];
+                    positions[misses++] = i;
+                } else if (value)
+                    result |= std::uint64_t(1) << i;
+            }
+
+            if (misses == 0)
+                return result;
+
+            const auto begin = std::chrono::steady_clock::now();
+            const std::uint64_t found = predicate(agent, values, missing, misses);
+            _callbackTime += std::chrono::steady_clock::now() - begin;
+
+            for (std::size_t i = 0; i < misses; ++i) {
+                const bool value = (found >> i) & 1;
+                store(values, missing[i], arity, value);
+
+                if (value)
+                    result |= std::uint64_t(1) << positions[i];
+            }
+
+            return result;
+        }
+
+        void PredicateCache::setEpoch(std::uint64_t epoch)
+        {
+            if (epoch == _epoch)
+                return;
+
+            _epoch = epoch;
+            invalidate();
+        }
+
+        std::uint64_t PredicateCache::invalidate()
+        {
+            _worldVersion = ++_version;
+            return _version;
+        }
+
+        std::uint64_t PredicateCache::invalidate(const std::size_t predicate)
+        {
+            if (predicate >= _predicateVersions.size())
+                _predicateVersions.resize(predicate + 1, 0);
+
+            _predicateVersions[predicate] = ++_version;
+            return _version;
+        }
+
+        void PredicateCache::clear()
+        {
+            _entries.clear();
+        }
+
+        void PredicateCache::resetStatistics()
+        {
+            _hits = 0;
+            _misses = 0;
+            _callbackTime = std::chrono::nanoseconds{ 0 };
+        }
+
+        std::uint64_t PredicateCache::key(const std::vector<Value> &values, const PredicateBind &bind, const std::size_t arity) const
+        {
+            std::uint64_t key = bind.id();
+
+            // Slots are indices into value table, so hash values themselves
+            for (std::size_t i = 0; i < arity; ++i) {
+                const std::size_t slot = bind.slot(i);
+
+                if (slot == unbound) {
+                    key = combine(key, unbound);
+                } else {
+                    key = combine(key, values[slot].type);
+                    key = combine(key, values[slot].data);
+                }
+            }
+
+            return key;
+        }
+
+        bool PredicateCache::find(const std::vector<Value> &values, const PredicateBind &bind, const std::size_t arity, bool &value)
+        {
+            const std::uint64_t predicateVersion = bind.id() < _predicateVersions.size() ? _predicateVersions[bind.id()] : 0;
+            const auto it = _entries.find(key(values, bind, arity));
+
+            if (it != _entries.end()) {
+                const Entry &entry = (*it).second;
+
+                if (entry.version >= _worldVersion &&
+                    entry.version >= predicateVersion &&
+                    matches(entry, values, bind, arity)) {
+                    ++_hits;
+                    value = entry.value;
+                    return true;
+                }
+            }
+
+            ++_misses;
+            return false;
+        }
+
+        void PredicateCache::store(const std::vector<Value> &values, const PredicateBind &bind, const std::size_t arity, bool value)
+        {
+            // Stale or colliding entry is simply replaced
+            Entry &entry = _entries[key(values, bind, arity)];
+            entry.predicate = bind.id();
+            entry.args.clear();
+
+            for (std::size_t i = 0; i < arity; ++i) {
+                const std::size_t slot = bind.slot(i);
+
+                if (slot == unbound)
+                    entry.args.push_back({ std::uint32_t(-1), ValueKind::None, 0 });
+                else
+                    entry.args.push_back(values[slot]);
+            }
+
+            entry.version = _version;
+            entry.value = value;
+        }
+
+        bool PredicateCache::matches(const Entry &entry, const std::vector<Value> &values, const PredicateBind &bind, const std::size_t arity) const
+        {
+            if (entry.predicate != bind.id() || entry.args.size() != arity)
+                return false;
+
+            for (std::size_t i = 0; i < arity; ++i) {
+                const std::size_t slot = bind.slot(i);
+                const Value &arg = entry.args[i];
+
+                if (slot == unbound) {
+                    if (arg.kind != ValueKind::None)
+                        return false;
+                } else if (arg != values[slot])
+                    return false;
+            }
+
+            return true;
+        }
+    }
+}
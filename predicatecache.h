@@ -0,0 +1,84 @@
+#pragma once
+
+#include "compileddomain.h"
+
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Memoizes predicate results by predicate and bound values,
+        // survives between plans until world or predicate is invalidated.
+        // Agent is not part of the key, so use one cache per agent
+        class PredicateCache
+        {
+        public:
+            PredicateCache();
+
+            bool evaluate(
+                const CompiledPredicate &predicate,
+                Agent *agent,
+                const std::vector<Value> &values,
+                const PredicateBind &bind
+            );
+            // Only missing results go to predicate, in one call
+            std::uint64_t evaluate(
+                const CompiledPredicate &predicate,
+                Agent *agent,
+                const std::vector<Value> &values,
+                const PredicateBind *binds,
+                std::size_t count
+            );
+
+            // Bump world version, all cached results become stale
+            std::uint64_t invalidate();
+            // Only results of given predicate become stale
+            std::uint64_t invalidate(const std::size_t predicate);
+            std::uint64_t version() const { return _version; }
+
+            // Results are keyed by predicate id, so results of other
+            // epoch of domain are dropped, see Domain::epoch
+            void setEpoch(std::uint64_t epoch);
+            std::uint64_t epoch() const { return _epoch; }
+
+            void clear();
+
+            std::size_t size() const { return _entries.size(); }
+            std::size_t hits() const { return _hits; }
+            std::size_t misses() const { return _misses; }
+            // Time spent in predicate callbacks on misses
+            std::chrono::nanoseconds callbackTime() const { return _callbackTime; }
+            void resetStatistics();
+
+        private:
+            struct Entry
+            {
+                std::size_t predicate;
+                std::vector<Value> args;
+                std::uint64_t version;
+                bool value;
+            };
+
+        private:
+            std::uint64_t key(const std::vector<Value> &values, const PredicateBind &bind, const std::size_t arity) const;
+            bool find(const std::vector<Value> &values, const PredicateBind &bind, const std::size_t arity, bool &value);
+            void store(const std::vector<Value> &values, const PredicateBind &bind, const std::size_t arity, bool value);
+            bool matches(const Entry &entry, const std::vector<Value> &values, const PredicateBind &bind, const std::size_t arity) const;
+
+        private:
+            std::unordered_map<std::uint64_t, Entry> _entries;
+            std::vector<std::uint64_t> _predicateVersions;
+            std::uint64_t _version;
+            std::uint64_t _worldVersion;
+            std::uint64_t _epoch;
+            std::size_t _hits;
+            std::size_t _misses;
+            std::chrono::nanoseconds _callbackTime;
+
+        };
+    }
+}
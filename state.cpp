@@ -1,38 +1,246 @@
 #include "state.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GOAP_SSE2
+#endif
 
 namespace ai
 {
     namespace goap
     {
+        namespace
+        {
+            // splitmix64 finalizer used instead of random table
+            // since bind is already unique 64 bit key
+            std::uint64_t fingerprint(const PredicateBind &token, bool value)
+            {
+                std::uint64_t x = token.data + (value ? 0x9e3779b97f4a7c15ull : 0x6a09e667f3bcc909ull);
+                x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+                x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+                return x ^ (x >> 31);
+            }
+
+            // Predicate id is moved to the highest bits
+            // so facts are sorted by predicate first
+            const std::size_t idShift{ 64 - PredicateBind::Bits };
+
+            std::uint64_t toKey(const PredicateBind &token)
+            {
+                return (token.data >> PredicateBind::Bits) | (token.data << idShift);
+            }
+
+            PredicateBind fromKey(const std::uint64_t key)
+            {
+                PredicateBind token;
+                token.data = (key << PredicateBind::Bits) | (key >> idShift);
+                return token;
+            }
+
+            // First position in [from, size) with keys[position] >= key
+            std::size_t advance(const std::uint64_t *keys, std::size_t from, const std::size_t size, const std::uint64_t key)
+            {
+#if defined(__AVX2__)
+                // Signed compare only, so bias both sides
+                const __m256i bias = _mm256_set1_epi64x(std::int64_t(0x8000000000000000ull));
+                const __m256i k = _mm256_xor_si256(_mm256_set1_epi64x(std::int64_t(key)), bias);
+
+                while (from + 4 <= size) {
+                    const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + from)), bias);
+                    const int less = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v)));
+
+                    if (less != 0xF)
+                        break;
+
+                    from += 4;
+                }
+#elif defined(__SSE4_2__)
+                const __m128i bias = _mm_set1_epi64x(std::int64_t(0x8000000000000000ull));
+                const __m128i k = _mm_xor_si128(_mm_set1_epi64x(std::int64_t(key)), bias);
+
+                while (from + 2 <= size) {
+                    const __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + from)), bias);
+                    const int less = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(k, v)));
+
+                    if (less != 0x3)
+                        break;
+
+                    from += 2;
+                }
+#endif
+                while (from < size && keys[from] < key)
+                    ++from;
+
+                return from;
+            }
+
+            bool equal(const std::uint64_t *l, const std::uint64_t *r, const std::size_t size)
+            {
+                std::size_t i{ 0 };
+
+#if defined(__AVX2__)
+                for (; i + 4 <= size; i += 4) {
+                    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(l + i));
+                    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r + i));
+
+                    if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(a, b)) != -1)
+                        return false;
+                }
+#elif defined(__SSE4_2__) || defined(GOAP_SSE2)
+                for (; i + 2 <= size; i += 2) {
+                    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(l + i));
+                    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r + i));
+
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) != 0xFFFF)
+                        return false;
+                }
+#endif
+                for (; i < size; ++i) {
+                    if (l[i] != r[i])
+                        return false;
+                }
+
+                return true;
+            }
+        }
+
+        State::State() :
+            State(nullptr)
+        {
+        }
+
+        State::State(std::pmr::memory_resource *resource) :
+            _resource{ resource },
+            _size{ 0 },
+            _capacity{ InlineCapacity },
+            _keys{ _local },
+            _bits{ _local + InlineCapacity },
+            _hash{ 0 }
+        {
+            _bits[0] = 0;
+        }
+
+        State::State(const State &other) :
+            State(other._resource)
+        {
+            assign(other);
+        }
+
+        State::State(State &&other) noexcept :
+            State(other._resource)
+        {
+            *this = std::move(other);
+        }
+
+        State::~State()
+        {
+            release();
+        }
+
+        State &State::operator=(const State &other)
+        {
+            if (this != &other)
+                assign(other);
+
+            return *this;
+        }
+
+        State &State::operator=(State &&other) noexcept
+        {
+            if (this == &other)
+                return *this;
+
+            if (other._keys == other._local || other._resource != _resource) {
+                assign(other);
+            } else {
+                release();
+                _keys = other._keys;
+                _bits = other._bits;
+                _capacity = other._capacity;
+                _size = other._size;
+                _hash = other._hash;
+
+                other._keys = other._local;
+                other._bits = other._local + InlineCapacity;
+                other._capacity = InlineCapacity;
+                other._bits[0] = 0;
+            }
+
+            other._size = 0;
+            other._hash = 0;
+
+            return *this;
+        }
+
         void State::set(const PredicateBind &token, bool value)
         {
-            const auto it = _stateMap.find(token);
+            const std::uint64_t key = toKey(token);
+            const std::size_t i = lowerBound(key);
 
-            if (it == _stateMap.end())
-                _tokenMap.insert({ token.id, token });
+            if (i < _size && _keys[i] == key) {
+                if (this->value(i) == value)
+                    return;
 
-            _stateMap.insert_or_assign(token, value);
+                _hash ^= fingerprint(token, !value);
+                _bits[i >> 6] ^= std::uint64_t(1) << (i & 63);
+            } else
+                insert(i, key, value);
+
+            _hash ^= fingerprint(token, value);
         }
 
         bool State::get(const PredicateBind &token) const
         {
-            const auto it = _stateMap.find(token);
+            const std::uint64_t key = toKey(token);
+            const std::size_t i = lowerBound(key);
 
-            if (it == _stateMap.end())
+            if (i == _size || _keys[i] != key)
                 return false;
 
-            return (*it).second;
+            return value(i);
+        }
+
+        bool State::contains(const PredicateBind &token) const
+        {
+            const std::uint64_t key = toKey(token);
+            const std::size_t i = lowerBound(key);
+            return i < _size && _keys[i] == key;
+        }
+
+        PredicateBind State::bind(const std::size_t i) const
+        {
+            return fromKey(_keys[i]);
+        }
+
+        std::pair<std::size_t, std::size_t> State::range(const std::size_t index) const
+        {
+            const std::uint64_t key = std::uint64_t(index) << idShift;
+            const std::size_t first = lowerBound(key);
+            const std::size_t last = index < PredicateBind::MaxIds ? lowerBound(key + (std::uint64_t(1) << idShift)) : _size;
+            return{ first, last };
         }
 
         bool State::meets(const State &goal) const
         {
-            for (const auto &value : _stateMap) {
-                const auto it = goal._stateMap.find(value.first);
+            if (_size > goal._size)
+                return false;
 
-                if (it == goal._stateMap.end() || (*it).second != value.second)
+            std::size_t j{ 0 };
+
+            for (std::size_t i = 0; i < _size; ++i) {
+                j = advance(goal._keys, j, goal._size, _keys[i]);
+
+                if (j == goal._size || goal._keys[j] != _keys[i] || goal.value(j) != value(i))
                     return false;
+
+                ++j;
             }
 
             return true;
@@ -40,21 +248,119 @@ namespace ai
 
         double State::operator-(const State &other) const
         {
-            double result{ 0.0 };
+            // Count facts which other state doesn't satisfy
+            std::size_t result{ 0 };
+            std::size_t j{ 0 };
 
-            for (const auto &value : _stateMap) {
-                const auto it = _stateMap.find(value.first);
+            for (std::size_t i = 0; i < _size; ++i) {
+                j = advance(other._keys, j, other._size, _keys[i]);
 
-                if (it == _stateMap.end() || (*it).second != value.second)
-                    result += 1.0;
+                if (j == other._size || other._keys[j] != _keys[i]) {
+                    ++result;
+                    continue;
+                }
+
+                if (other.value(j) != value(i))
+                    ++result;
+
+                ++j;
             }
 
-            return result;
+            return double(result);
         }
 
         bool State::operator==(const State &other) const
         {
-            return _stateMap == other._stateMap;
+            // Unused value bits are always zero
+            return _hash == other._hash &&
+                _size == other._size &&
+                equal(_keys, other._keys, _size) &&
+                equal(_bits, other._bits, words(_size));
+        }
+
+        std::uint64_t *State::allocate(const std::size_t capacity)
+        {
+            const std::size_t size = capacity + words(capacity);
+
+            if (_resource != nullptr)
+                return static_cast<std::uint64_t *>(_resource->allocate(size * sizeof(std::uint64_t), alignof(std::uint64_t)));
+
+            return new std::uint64_t[size];
+        }
+
+        std::size_t State::lowerBound(const std::uint64_t key) const
+        {
+            return std::lower_bound(_keys, _keys + _size, key) - _keys;
+        }
+
+        void State::reserve(const std::size_t capacity)
+        {
+            if (capacity <= _capacity)
+                return;
+
+            std::uint64_t *keys = allocate(capacity);
+            std::uint64_t *bits = keys + capacity;
+            std::memcpy(keys, _keys, _size * sizeof(std::uint64_t));
+            std::memcpy(bits, _bits, words(_size) * sizeof(std::uint64_t));
+            std::fill(bits + words(_size), bits + words(capacity), std::uint64_t(0));
+
+            release();
+            _keys = keys;
+            _bits = bits;
+            _capacity = static_cast<std::uint32_t>(capacity);
+        }
+
+        void State::insert(const std::size_t i, const std::uint64_t key, bool value)
+        {
+            if (_size == _capacity)
+                reserve(_capacity * 2);
+
+            std::memmove(_keys + i + 1, _keys + i, (_size - i) * sizeof(std::uint64_t));
+            _keys[i] = key;
+
+            // Shift value bits starting from i by one
+            const std::size_t first = i >> 6;
+
+            for (std::size_t w = _size >> 6; w > first; --w)
+                _bits[w] = (_bits[w] << 1) | (_bits[w - 1] >> 63);
+
+            const std::uint64_t low = (std::uint64_t(1) << (i & 63)) - 1;
+            const std::uint64_t word = _bits[first];
+            _bits[first] = (word & low) | ((word & ~low) << 1) | (std::uint64_t(value) << (i & 63));
+
+            ++_size;
+        }
+
+        void State::assign(const State &other)
+        {
+            if (other._size > _capacity) {
+                // Exact size, so copy is a single allocation
+                release();
+                _keys = allocate(other._size);
+                _bits = _keys + other._size;
+                _capacity = other._size;
+            }
+
+            std::memcpy(_keys, other._keys, other._size * sizeof(std::uint64_t));
+            std::memcpy(_bits, other._bits, words(other._size) * sizeof(std::uint64_t));
+            std::fill(_bits + words(other._size), _bits + words(_capacity), std::uint64_t(0));
+            _size = other._size;
+            _hash = other._hash;
+        }
+
+        void State::release()
+        {
+            if (_keys != _local) {
+                if (_resource != nullptr)
+                    _resource->deallocate(_keys, (_capacity + words(_capacity)) * sizeof(std::uint64_t), alignof(std::uint64_t));
+                else
+                    delete[] _keys;
+            }
+
+            _keys = _local;
+            _bits = _local + InlineCapacity;
+            _capacity = InlineCapacity;
+            _bits[0] = 0;
         }
     }
 }
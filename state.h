@@ -1,8 +1,8 @@
 #pragma once
 
-#include <unordered_map>
-#include <map>
-#include <string>
+#include <cstdint>
+#include <utility>
+#include <memory_resource>
 
 #include "predicate.h"
 
@@ -10,24 +10,68 @@ namespace ai
 {
     namespace goap
     {
+        // Facts are stored as sorted 64 bit keys with packed value bits,
+        // keys and bits share single buffer so copying a state is one
+        // allocation at most (none for small states). Copies allocate
+        // from the same memory resource, null resource is global heap
         class State
         {
         public:
+            State();
+            explicit State(std::pmr::memory_resource *resource);
+            State(const State &other);
+            State(State &&other) noexcept;
+            ~State();
+
+            State &operator=(const State &other);
+            State &operator=(State &&other) noexcept;
+
             void set(const PredicateBind &token, bool value);
             bool get(const PredicateBind &token) const;
-            auto range(const std::size_t index) const
+            bool contains(const PredicateBind &token) const;
+
+            // Facts are addressed by position, facts with
+            // the same predicate are placed next to each other
+            std::size_t size() const { return _size; }
+            PredicateBind bind(const std::size_t i) const;
+            bool value(const std::size_t i) const
             {
-                return _tokenMap.equal_range(index);
+                return (_bits[i >> 6] >> (i & 63)) & 1;
             }
+            std::pair<std::size_t, std::size_t> range(const std::size_t index) const;
+
             bool meets(const State &goal) const;
 
+            // Zobrist-style fingerprint of all facts,
+            // equal states always have equal fingerprints
+            std::uint64_t hash() const { return _hash; }
+
             double operator-(const State &other) const;
             bool operator==(const State &other) const;
 
         private:
-            friend class Planner;
-            std::unordered_map<PredicateBind, bool> _stateMap;
-            std::multimap<std::size_t, PredicateBind> _tokenMap;
+            static constexpr std::size_t InlineCapacity = 15;
+
+            static std::size_t words(const std::size_t capacity)
+            {
+                return (capacity + 63) / 64;
+            }
+
+            std::uint64_t *allocate(const std::size_t capacity);
+            std::size_t lowerBound(const std::uint64_t key) const;
+            void reserve(const std::size_t capacity);
+            void insert(const std::size_t i, const std::uint64_t key, bool value);
+            void assign(const State &other);
+            void release();
+
+        private:
+            std::pmr::memory_resource *_resource;
+            std::uint32_t _size;
+            std::uint32_t _capacity;
+            std::uint64_t *_keys;
+            std::uint64_t *_bits;
+            std::uint64_t _hash;
+            std::uint64_t _local[InlineCapacity + 1];
 
         };
     }
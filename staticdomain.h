@@ -0,0 +1,321 @@
+#pragma once
+
+#include "domain.h"
+
+#include <array>
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Rows of static domain tables. Ids are indices into tables
+        // of spec, types and predicates are usually named by its enums
+        struct StaticPredicate
+        {
+            const char *name;
+            std::uint8_t arity;
+            std::uint32_t types[PredicateBind::Arity];
+        };
+
+        // Conditions of actions follow each other in conditions table,
+        // preconditions of action come first and its effects after them
+        struct StaticAction
+        {
+            const char *name;
+            double cost;
+            std::uint8_t args;
+            std::uint32_t types[ActionBind::Arity];
+            std::uint16_t preconditions;
+            std::uint16_t effects;
+            // Action is bound by bind function of spec
+            bool bind;
+        };
+
+        // Compile time checks of spec tables, see StaticDomain
+        template<typename Spec>
+        struct StaticCheck
+        {
+            static constexpr std::size_t TypeCount = std::size(Spec::types);
+            static constexpr std::size_t PredicateCount = std::size(Spec::predicates);
+            static constexpr std::size_t ActionCount = std::size(Spec::actions);
+            static constexpr std::size_t ConditionCount = std::size(Spec::conditions);
+
+            static constexpr bool predicates()
+            {
+                for (const auto &predicate : Spec::predicates) {
+                    if (predicate.arity > PredicateBind::Arity)
+                        return false;
+
+                    for (std::size_t i = 0; i < predicate.arity; ++i) {
+                        if (predicate.types[i] >= TypeCount)
+                            return false;
+                    }
+                }
+
+                return true;
+            }
+
+            static constexpr bool actions()
+            {
+                std::size_t conditions{ 0 };
+
+                for (const auto &action : Spec::actions) {
+                    if (action.args > ActionBind::Arity || action.cost < 0.0)
+                        return false;
+
+                    for (std::size_t i = 0; i < action.args; ++i) {
+                        if (action.types[i] >= TypeCount)
+                            return false;
+                    }
+
+                    conditions += action.preconditions + action.effects;
+                }
+
+                return conditions == ConditionCount;
+            }
+
+            // Predicate of condition exists, its slots take action
+            // arguments of the same types as predicate does
+            static constexpr bool conditions()
+            {
+                std::size_t offset{ 0 };
+
+                for (const auto &action : Spec::actions) {
+                    const std::size_t count{ std::size_t(action.preconditions) + action.effects };
+
+                    for (std::size_t c = offset; c < offset + count && c < ConditionCount; ++c) {
+                        const CompiledCondition &condition = Spec::conditions[c];
+
+                        if (condition.predicate >= PredicateCount)
+                            return false;
+
+                        const StaticPredicate &predicate = Spec::predicates[condition.predicate];
+
+                        if (condition.arity != predicate.arity)
+                            return false;
+
+                        for (std::size_t i = 0; i < condition.arity; ++i) {
+                            if (condition.slots[i] >= action.args || action.types[condition.slots[i]] != predicate.types[i])
+                                return false;
+                        }
+                    }
+
+                    offset += count;
+                }
+
+                return true;
+            }
+
+            // Regression binds arguments from effects, others need bind function
+            static constexpr bool bound()
+            {
+                std::size_t offset{ 0 };
+
+                for (const auto &action : Spec::actions) {
+                    const std::size_t effects{ offset + action.preconditions };
+                    offset = effects + action.effects;
+
+                    if (action.bind)
+                        continue;
+
+                    for (std::size_t arg = 0; arg < action.args; ++arg) {
+                        bool found{ false };
+
+                        for (std::size_t c = effects; c < offset && c < ConditionCount && !found; ++c) {
+                            for (std::size_t i = 0; i < Spec::conditions[c].arity; ++i)
+                                found = found || Spec::conditions[c].slots[i] == arg;
+                        }
+
+                        if (!found)
+                            return false;
+                    }
+                }
+
+                return true;
+            }
+        };
+
+        // Domain fixed at compile time. Spec is struct of constexpr tables
+        //   static constexpr const char *types[]
+        //   static constexpr StaticPredicate predicates[]
+        //   static constexpr StaticAction actions[]
+        //   static constexpr CompiledCondition conditions[]
+        // and of member templates instantiated per id. Each instantiation
+        // is a thunk with the body of its callable inlined, planner calls
+        // thunks through PredicateFunc and BindFunc pointers as usual
+        //   template<std::size_t Id> static bool evaluate(Agent *, const std::vector<Value> &, const PredicateBind &)
+        //   template<std::size_t Id> static bool bind(...), for actions with bind flag, see BindFunc
+        // Tables are checked when domain is instantiated and compiled
+        // without names lookups, once for all planners of spec
+        template<typename Spec>
+        class StaticDomain
+        {
+        public:
+            using Check = StaticCheck<Spec>;
+
+            static_assert(Check::PredicateCount <= PredicateBind::MaxIds && Check::ActionCount <= ActionBind::MaxIds,
+                "Spec exceeds ids of bind layout, see GOAP_PREDICATE_BITS");
+            static_assert(Check::predicates(), "Spec predicate exceeds bind arity or has unknown type");
+            static_assert(Check::actions(), "Spec action has unknown type or its conditions don't add up to conditions table");
+            static_assert(Check::conditions(), "Spec condition doesn't match its predicate or action arguments");
+            static_assert(Check::bound(), "Spec action argument is missing in effects, action needs bind function");
+
+            // Shared snapshot, safe to use from any thread.
+            // Planners of spec are constructed from it
+            static const std::shared_ptr<const CompiledDomain> &compiled()
+            {
+                static const std::shared_ptr<const CompiledDomain> domain{
+                    std::make_shared<const CompiledDomain>(actions(), predicates(), std::make_shared<SymbolTable>())
+                };
+
+                return domain;
+            }
+
+            // Adds tables to runtime domain, so dynamic types, predicates
+            // and actions may be added on top. Spec ids hold for empty
+            // domain, on failure reason is left in error of domain
+            static bool install(Domain &domain)
+            {
+                const auto functions = evaluators(std::make_index_sequence<Check::PredicateCount>{});
+                const auto binds = binders(std::make_index_sequence<Check::ActionCount>{});
+
+                for (const char *type : Spec::types) {
+                    if (!domain.addType(type))
+                        return false;
+                }
+
+                for (std::size_t p = 0; p < Check::PredicateCount; ++p) {
+                    const StaticPredicate &predicate = Spec::predicates[p];
+                    std::vector<std::string> types;
+
+                    for (std::size_t i = 0; i < predicate.arity; ++i)
+                        types.push_back(Spec::types[predicate.types[i]]);
+
+                    if (!domain.addPredicate(predicate.name, types, functions[p]))
+                        return false;
+                }
+
+                std::size_t offset{ 0 };
+
+                for (std::size_t a = 0; a < Check::ActionCount; ++a) {
+                    const StaticAction &action = Spec::actions[a];
+                    std::vector<ArgDesc> args;
+
+                    for (std::size_t i = 0; i < action.args; ++i)
+                        args.push_back({ "a" + std::to_string(i), Spec::types[action.types[i]] });
+
+                    std::vector<ConditionDesc> preconditions;
+                    std::vector<ConditionDesc> effects;
+
+                    for (std::size_t c = 0; c < std::size_t(action.preconditions) + action.effects; ++c) {
+                        const CompiledCondition &condition = Spec::conditions[offset + c];
+                        std::vector<std::string> names;
+
+                        for (std::size_t i = 0; i < condition.arity; ++i)
+                            names.push_back(args[condition.slots[i]].name);
+
+                        (c < action.preconditions ? preconditions : effects).push_back({
+                            Spec::predicates[condition.predicate].name, std::move(names), condition.state
+                        });
+                    }
+
+                    offset += std::size_t(action.preconditions) + action.effects;
+
+                    if (!domain.addAction(action.name, action.cost, args, preconditions, effects, binds[a]))
+                        return false;
+                }
+
+                return true;
+            }
+
+            // Conditions name spec predicates, their slots index values
+            static Goal goal(std::vector<Value> values, std::initializer_list<CompiledCondition> conditions)
+            {
+                Goal result{ std::move(values), {} };
+                result.conditions.reserve(conditions.size());
+
+                for (const auto &condition : conditions)
+                    result.conditions.push_back(convert(condition));
+
+                return result;
+            }
+
+        private:
+            static Condition convert(const CompiledCondition &condition)
+            {
+                return{
+                    condition.predicate,
+                    std::vector<std::size_t>(condition.slots, condition.slots + condition.arity),
+                    condition.state
+                };
+            }
+
+            template<std::size_t... Ids>
+            static std::array<PredicateFunc, sizeof...(Ids)> evaluators(std::index_sequence<Ids...>)
+            {
+                return{ { &Spec::template evaluate<Ids>... } };
+            }
+
+            template<std::size_t Id>
+            static BindFunc binder()
+            {
+                if constexpr (Spec::actions[Id].bind)
+                    return &Spec::template bind<Id>;
+                else
+                    return nullptr;
+            }
+
+            template<std::size_t... Ids>
+            static std::array<BindFunc, sizeof...(Ids)> binders(std::index_sequence<Ids...>)
+            {
+                return{ { binder<Ids>()... } };
+            }
+
+            static std::vector<Predicate> predicates()
+            {
+                const auto functions = evaluators(std::make_index_sequence<Check::PredicateCount>{});
+                std::vector<Predicate> result;
+                result.reserve(Check::PredicateCount);
+
+                for (std::size_t p = 0; p < Check::PredicateCount; ++p) {
+                    const StaticPredicate &predicate = Spec::predicates[p];
+                    result.push_back({
+                        predicate.name,
+                        std::vector<std::size_t>(predicate.types, predicate.types + predicate.arity),
+                        functions[p],
+                        nullptr
+                    });
+                }
+
+                return result;
+            }
+
+            static std::vector<Action> actions()
+            {
+                const auto binds = binders(std::make_index_sequence<Check::ActionCount>{});
+                std::vector<Action> result;
+                result.reserve(Check::ActionCount);
+                std::size_t offset{ 0 };
+
+                for (std::size_t a = 0; a < Check::ActionCount; ++a) {
+                    const StaticAction &action = Spec::actions[a];
+                    Action compiled{ action.name, action.cost, action.args, {}, {}, binds[a] };
+
+                    for (std::size_t c = 0; c < action.preconditions; ++c)
+                        compiled.preconditions.push_back(convert(Spec::conditions[offset++]));
+
+                    for (std::size_t c = 0; c < action.effects; ++c)
+                        compiled.effects.push_back(convert(Spec::conditions[offset++]));
+
+                    result.push_back(std::move(compiled));
+                }
+
+                return result;
+            }
+
+        };
+    }
+}
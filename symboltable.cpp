@@ -0,0 +1,54 @@
+#include "symboltable.h"
+
+#include <mutex>
+
+namespace ai
+{
+    namespace goap
+    {
+        Symbol SymbolTable::intern(std::string_view name)
+        {
+            Symbol symbol;
+
+            if (find(name, symbol))
+                return symbol;
+
+            std::unique_lock<std::shared_mutex> lock{ _mutex };
+            const auto it = _ids.find(name);
+
+            // Other thread was first
+            if (it != _ids.end())
+                return{ (*it).second };
+
+            symbol.id = static_cast<std::uint32_t>(_names.size());
+            _names.emplace_back(name);
+            _ids.insert({ _names.back(), symbol.id });
+
+            return symbol;
+        }
+
+        bool SymbolTable::find(std::string_view name, Symbol &symbol) const
+        {
+            std::shared_lock<std::shared_mutex> lock{ _mutex };
+            const auto it = _ids.find(name);
+
+            if (it == _ids.end())
+                return false;
+
+            symbol.id = (*it).second;
+            return true;
+        }
+
+        std::string_view SymbolTable::name(Symbol symbol) const
+        {
+            std::shared_lock<std::shared_mutex> lock{ _mutex };
+            return _names[symbol.id];
+        }
+
+        std::size_t SymbolTable::size() const
+        {
+            std::shared_lock<std::shared_mutex> lock{ _mutex };
+            return _names.size();
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "value.h"
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+
+namespace ai
+{
+    namespace goap
+    {
+        // Append only table of names, symbol ids are never reused.
+        // Safe to intern and read names from many threads
+        class SymbolTable
+        {
+        public:
+            Symbol intern(std::string_view name);
+            // Returns false if name was never interned
+            bool find(std::string_view name, Symbol &symbol) const;
+            // Name stays valid for lifetime of table
+            std::string_view name(Symbol symbol) const;
+            std::size_t size() const;
+
+        private:
+            mutable std::shared_mutex _mutex;
+            // Deque keeps names in place, so map keys stay valid
+            std::deque<std::string> _names;
+            std::unordered_map<std::string_view, std::uint32_t> _ids;
+
+        };
+    }
+}
@@ -1,16 +1,105 @@
 #pragma once
 
-#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
 
 namespace ai
 {
     namespace goap
     {
+        // Id of interned name, see SymbolTable
+        struct Symbol
+        {
+            std::uint32_t id;
+
+            bool operator==(const Symbol &other) const { return id == other.id; }
+            bool operator!=(const Symbol &other) const { return id != other.id; }
+        };
+
+        enum class ValueKind : std::uint8_t
+        {
+            None,
+            Symbol,
+            Integer,
+            Real,
+            Entity
+        };
+
+        // Typed value with payload packed into one word, so values are
+        // compared and copied as integers. Reals are compared bitwise
         struct Value
         {
-            std::size_t type;
-            // TODO: set actual value
-            std::string value;
+            std::uint32_t type;
+            ValueKind kind;
+            std::uint64_t data;
+
+            static Value symbol(const std::size_t type, Symbol symbol)
+            {
+                return{ static_cast<std::uint32_t>(type), ValueKind::Symbol, symbol.id };
+            }
+
+            static Value integer(const std::size_t type, std::int64_t integer)
+            {
+                return{ static_cast<std::uint32_t>(type), ValueKind::Integer, static_cast<std::uint64_t>(integer) };
+            }
+
+            static Value real(const std::size_t type, double real)
+            {
+                Value value{ static_cast<std::uint32_t>(type), ValueKind::Real, 0 };
+                std::memcpy(&value.data, &real, sizeof(real));
+                return value;
+            }
+
+            static Value entity(const std::size_t type, std::uint64_t handle)
+            {
+                return{ static_cast<std::uint32_t>(type), ValueKind::Entity, handle };
+            }
+
+            Symbol asSymbol() const { return{ static_cast<std::uint32_t>(data) }; }
+            std::int64_t asInteger() const { return static_cast<std::int64_t>(data); }
+            std::uint64_t asEntity() const { return data; }
+
+            double asReal() const
+            {
+                double real;
+                std::memcpy(&real, &data, sizeof(real));
+                return real;
+            }
+
+            bool operator==(const Value &other) const
+            {
+                return type == other.type && kind == other.kind && data == other.data;
+            }
+
+            bool operator!=(const Value &other) const
+            {
+                return !(*this == other);
+            }
+        };
+
+        // Payload of goal value, symbol is given by name
+        // and interned when goal is made
+        struct Literal
+        {
+            ValueKind kind;
+            std::string_view name;
+            std::uint64_t data;
+
+            Literal(const char *symbol) : kind{ ValueKind::Symbol }, name{ symbol }, data{ 0 } {}
+            Literal(std::string_view symbol) : kind{ ValueKind::Symbol }, name{ symbol }, data{ 0 } {}
+            Literal(Symbol symbol) : kind{ ValueKind::Symbol }, name{}, data{ symbol.id } {}
+            Literal(int integer) : Literal(static_cast<std::int64_t>(integer)) {}
+            Literal(std::int64_t integer) : kind{ ValueKind::Integer }, name{}, data{ static_cast<std::uint64_t>(integer) } {}
+            Literal(double real) : kind{ ValueKind::Real }, name{}, data{ Value::real(0, real).data } {}
+
+            static Literal entity(std::uint64_t handle)
+            {
+                Literal literal{ std::int64_t(0) };
+                literal.kind = ValueKind::Entity;
+                literal.data = handle;
+                return literal;
+            }
         };
     }
 }